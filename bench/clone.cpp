@@ -0,0 +1,128 @@
+// clone.cpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+//
+// What-if runs on cloned worlds (world.hpp): how long World::clone takes,
+// whether a clone on the original's stream stays identical to it, and
+// seeded clones stepped in parallel while the original keeps ticking.
+//
+//   make bench && bench/clone [SHIPS] [CLONES] [TICKS]
+//
+// Defaults to 2000 ships over the usual universe, 4 seeded clones, and 200
+// ticks (a minute of sim time) ahead. Times are wall milliseconds.
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "constants.hpp"
+#include "rand.hpp"
+#include "statehash.hpp"
+#include "world.hpp"
+
+
+using namespace tinyspace;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+
+namespace {
+
+uint64_t const SEED   = 7;
+size_t   const WARMUP = 50; // ticks before cloning, so traffic and combat are under way
+int      const RUNS   = 5;
+double   const DELTA  = TICK_TIME / 1000.0;
+
+
+double since( steady_clock::time_point start )
+{
+    return duration<double>( steady_clock::now() - start ).count();
+}
+
+
+uint64_t hashOf( World const& world )
+{
+    return hashState( world.schedule, world.sectors, world.ships, world.locality );
+}
+
+
+void step( World& world, size_t ticks )
+{
+    for ( size_t i = 0; i < ticks; ++i ) world.advance( DELTA );
+}
+
+
+size_t liveShips( World const& world )
+{
+    size_t live = 0;
+    for ( auto& ship : world.ships ) if ( ! ship.parked && ship.currentHull > 0 ) ++live;
+    return live;
+}
+
+} // anonymous
+
+
+int main( int argc, char** argv )
+{
+    size_t const shipCount  = argc > 1 ? strtoul( argv[ 1 ], nullptr, 10 ) : 2000;
+    size_t const cloneCount = argc > 2 ? strtoul( argv[ 2 ], nullptr, 10 ) : 4;
+    size_t const ticks      = argc > 3 ? strtoul( argv[ 3 ], nullptr, 10 ) : 200;
+
+    ReplayConfig config;
+    config.seed = SEED;
+    seedRand( config.seed );
+    World world( config, shipCount, SECTOR_BOUNDS, SECTOR_SIZE );
+    step( world, WARMUP );
+
+    double best = 1e9;
+    for ( int run = 0; run < RUNS; ++run )
+    {
+        auto start = steady_clock::now();
+        auto copy  = world.clone();
+        best = std::min( best, since( start ));
+    }
+    printf( "%zu ships, %zu sectors -- clone %.3fms (best of %d)\n",
+        world.ships.size(), SECTOR_BOUNDS.x * SECTOR_BOUNDS.y, best * 1000, RUNS );
+
+    // a clone on the original's stream has to stay the original, stepped
+    // on another thread while the original steps here
+    auto twin = world.clone();
+    std::thread twinThread( [ & ]() { step( *twin, ticks ); } );
+    step( world, ticks );
+    twinThread.join();
+    if ( hashOf( *twin ) != hashOf( world ))
+    {
+        fprintf( stderr, "clone: diverged from the original within %zu ticks\n", ticks );
+        return 1;
+    }
+    printf( "same-stream clone matches the original after %zu ticks\n\n", ticks );
+
+    // what-ifs -- each seeded clone plays the next TICKS its own way
+    vector<std::unique_ptr<World>> clones;
+    for ( size_t i = 0; i < cloneCount; ++i ) clones.push_back( world.clone( SEED + 1 + i ));
+
+    auto start = steady_clock::now();
+    vector<std::thread> threads;
+    for ( auto& clone : clones )
+    {
+        World* what = clone.get();
+        threads.emplace_back( [ what, ticks ]() { step( *what, ticks ); } );
+    }
+    step( world, ticks );
+    for ( auto& thread : threads ) thread.join();
+    double elapsed = since( start );
+
+    printf( "%-10s %12s %18s\n", "world", "live ships", "state hash" );
+    printf( "%-10s %12zu %18llx\n", "original", liveShips( world ), static_cast<unsigned long long>( hashOf( world )));
+    for ( size_t i = 0; i < clones.size(); ++i )
+    {
+        printf( "seed %-5llu %12zu %18llx\n", static_cast<unsigned long long>( SEED + 1 + i ),
+            liveShips( *clones[ i ] ), static_cast<unsigned long long>( hashOf( *clones[ i ] )));
+    }
+    printf( "\n%zu clones and the original, %zu ticks each: %.1fms on %u hardware threads\n",
+        clones.size(), ticks, elapsed * 1000, std::thread::hardware_concurrency() );
+    return 0;
+}
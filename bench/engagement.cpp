@@ -0,0 +1,83 @@
+// engagement.cpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+//
+// Calibration of AGGREGATE_ENGAGEMENT (constants.hpp): the same seeds run
+// with shot-by-shot combat everywhere (--shot-combat) and with sectors below
+// full detail resolving it in aggregate (the default), counting kills.
+// Aggregate combat is calibrated while the two kill about as many ships.
+//
+//   make bench && bench/engagement [SEEDS] [TICKS]
+//
+// Defaults to 32 seeds of 10000 ticks (50 minutes of sim time) over the
+// usual universe. Kills are ships whose hull reached 0, counted per tick --
+// a ship killed, respawned and killed again counts twice.
+
+
+#include <cstdio>
+#include <cstdlib>
+#include "constants.hpp"
+#include "rand.hpp"
+#include "world.hpp"
+
+
+using namespace tinyspace;
+
+
+namespace {
+
+uint64_t const FIRST_SEED = 7;
+double   const DELTA      = TICK_TIME / 1000.0;
+
+
+size_t kills( uint64_t seed, size_t ticks, bool useShotCombat )
+{
+    ReplayConfig config;
+    config.seed          = seed;
+    config.useShotCombat = useShotCombat;
+    seedRand( config.seed );
+    World world( config, SHIP_COUNT, SECTOR_BOUNDS, SECTOR_SIZE );
+
+    vector<bool> wasDead( world.ships.size() );
+    size_t count = 0;
+    for ( size_t tick = 0; tick < ticks; ++tick )
+    {
+        world.advance( DELTA );
+        // records don't move -- nothing here reorders storage
+        for ( size_t i = 0; i < world.ships.size(); ++i )
+        {
+            Ship const& ship = world.ships[ i ];
+            bool isDead = ! ship.parked && ship.currentHull == 0;
+            if ( isDead && ! wasDead[ i ] ) ++count;
+            wasDead[ i ] = isDead;
+        }
+    }
+    return count;
+}
+
+} // anonymous
+
+
+int main( int argc, char** argv )
+{
+    size_t const seeds = argc > 1 ? strtoul( argv[ 1 ], nullptr, 10 ) : 32;
+    size_t const ticks = argc > 2 ? strtoul( argv[ 2 ], nullptr, 10 ) : 10000;
+
+    printf( "AGGREGATE_ENGAGEMENT %.2f, %zu ticks per run\n\n", AGGREGATE_ENGAGEMENT, ticks );
+    printf( "%-8s %12s %12s %8s\n", "seed", "shot-combat", "aggregate", "ratio" );
+
+    size_t shotTotal = 0, aggregateTotal = 0;
+    for ( uint64_t seed = FIRST_SEED; seed < FIRST_SEED + seeds; ++seed )
+    {
+        size_t shot      = kills( seed, ticks, true );
+        size_t aggregate = kills( seed, ticks, false );
+        double ratio     = shot ? double( aggregate ) / shot : 0.0;
+        printf( "%-8llu %12zu %12zu %8.3f\n", static_cast<unsigned long long>( seed ), shot, aggregate, ratio );
+        shotTotal      += shot;
+        aggregateTotal += aggregate;
+    }
+
+    // single seeds see a few dozen kills -- only the total says much
+    printf( "\n%-8s %12zu %12zu %8.3f\n", "total",
+        shotTotal, aggregateTotal, shotTotal ? double( aggregateTotal ) / shotTotal : 0.0 );
+    return 0;
+}
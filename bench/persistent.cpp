@@ -0,0 +1,182 @@
+// persistent.cpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+//
+// Sector rosters and weapon lists at scale: snapshotting them by plain copy
+// versus as Saveable persistent containers (opt/persistent.hpp).
+//
+//   make bench && bench/persistent [SHIPS] [SECTORS] [MOVES]
+//
+// Defaults to 100000 ships over 100 sectors, with 100000 roster moves (an
+// erase from one sector and an insert into another) per timed pass. Times are
+// wall milliseconds, best of a few runs.
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+#include "opt/persistent.hpp"
+#include "opt/saveable.hpp"
+
+
+using namespace tinyspace;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+
+namespace {
+
+size_t const WEAPONS_PER_SHIP = 4;
+int    const RUNS             = 5;
+
+struct Ship {}; // only its address is used
+
+typedef std::set<Ship*>                        plain_roster_t;
+typedef PersistentSet<Ship*>                   persistent_roster_t;
+typedef std::vector<std::shared_ptr<int>>      plain_weapons_t;
+typedef PersistentVector<std::shared_ptr<int>> persistent_weapons_t;
+
+struct Move { Ship* ship; size_t from, to; };
+
+// Best wall milliseconds of fn over RUNS -- setup runs untimed before each
+double best( std::function<void()> const& setup, std::function<void()> const& fn )
+{
+    double r = 1e300;
+    for ( int i = 0; i < RUNS; ++i )
+    {
+        setup();
+        auto start = steady_clock::now();
+        fn();
+        r = std::min( r, duration<double, std::milli>( steady_clock::now() - start ).count() );
+    }
+    return r;
+}
+
+void report( char const* what, double plain, double persistent )
+{
+    printf( "%-34s %12.3f %12.3f\n", what, plain, persistent );
+}
+
+} // anonymous
+
+
+int main( int argc, char** argv )
+{
+    size_t const shipCount   = argc > 1 ? strtoul( argv[ 1 ], nullptr, 10 ) : 100000;
+    size_t const sectorCount = argc > 2 ? strtoul( argv[ 2 ], nullptr, 10 ) : 100;
+    size_t const moveCount   = argc > 3 ? strtoul( argv[ 3 ], nullptr, 10 ) : 100000;
+
+    std::mt19937 rng( 7 );
+    std::vector<Ship>   ships( shipCount );
+    std::vector<size_t> sectorOf( shipCount );
+    for ( auto& sector : sectorOf ) sector = rng() % sectorCount;
+
+    // the same moves for every pass, replayed from the same start
+    std::vector<Move> moves;
+    {
+        std::vector<size_t> at( sectorOf );
+        for ( size_t i = 0; i < moveCount; ++i )
+        {
+            size_t ship = rng() % shipCount;
+            size_t to   = rng() % sectorCount;
+            moves.push_back( { &ships[ ship ], at[ ship ], to } );
+            at[ ship ] = to;
+        }
+    }
+
+    std::vector<plain_roster_t>                plain( sectorCount );
+    std::vector<Saveable<persistent_roster_t>> persistent( sectorCount );
+    auto reset = [ & ]()
+    {
+        for ( auto& roster : plain ) roster.clear();
+        for ( size_t i = 0; i < shipCount; ++i ) plain[ sectorOf[ i ]].insert( &ships[ i ] );
+        for ( size_t s = 0; s < sectorCount; ++s )
+        {
+            persistent[ s ] = persistent_roster_t( plain[ s ].begin(), plain[ s ].end() );
+        }
+    };
+    auto movePlain = [ & ]()
+    {
+        for ( auto& move : moves )
+        {
+            plain[ move.from ].erase( move.ship );
+            plain[ move.to ].insert( move.ship );
+        }
+    };
+    auto movePersistent = [ & ]()
+    {
+        for ( auto& move : moves )
+        {
+            persistent[ move.from ].edit().erase( move.ship );
+            persistent[ move.to ].edit().insert( move.ship );
+        }
+    };
+
+    printf( "%zu ships, %zu sectors, %zu moves -- wall ms, best of %d\n\n", shipCount, sectorCount, moveCount, RUNS );
+    printf( "%-34s %12s %12s\n", "sector rosters", "plain copy", "persistent" );
+
+    // snapshot -- copy every roster, versus open a snapshot
+    std::vector<plain_roster_t> copies;
+    report( "take snapshot",
+        best( [ & ]() { reset(); copies.clear(); },
+              [ & ]() { copies = plain; } ),
+        best( [ & ]() { reset(); },
+              [ & ]() { beginSnapshot(); } ));
+    endSnapshot();
+
+    report( "moves, no save",
+        best( reset, movePlain ),
+        best( reset, movePersistent ));
+
+    report( "moves, save in flight",
+        best( [ & ]() { reset(); copies = plain; }, movePlain ),
+        best( [ & ]() { endSnapshot(); reset(); beginSnapshot(); }, movePersistent ));
+
+    // reconcile -- drop the copies, versus drop the paths the moves left behind
+    report( "end snapshot",
+        best( [ & ]() { reset(); copies = plain; movePlain(); },
+              [ & ]() { copies.clear(); copies.shrink_to_fit(); } ),
+        best( [ & ]() { endSnapshot(); reset(); beginSnapshot(); movePersistent(); },
+              [ & ]() { endSnapshot(); } ));
+
+    size_t sum = 0;
+    report( "sweep every roster",
+        best( reset, [ & ]() { for ( auto& roster : plain ) for ( Ship* ship : roster ) sum += ship != nullptr; } ),
+        best( reset, [ & ]() { for ( auto& roster : persistent ) for ( Ship* ship : roster() ) sum += ship != nullptr; } ));
+
+    // weapon lists -- a handful each, set at spawn and read every tick
+    std::vector<plain_weapons_t>                plainWeapons( shipCount );
+    std::vector<Saveable<persistent_weapons_t>> persistentWeapons( shipCount );
+    for ( size_t i = 0; i < shipCount; ++i )
+    {
+        for ( size_t w = 0; w < WEAPONS_PER_SHIP; ++w ) plainWeapons[ i ].push_back( std::make_shared<int>( w ));
+        persistentWeapons[ i ] = persistent_weapons_t( plainWeapons[ i ] );
+    }
+    std::vector<plain_weapons_t> weaponCopies;
+
+    printf( "\n%-34s %12s %12s\n", "weapon lists", "plain copy", "persistent" );
+    report( "take snapshot",
+        best( [ & ]() { weaponCopies.clear(); },
+              [ & ]() { weaponCopies = plainWeapons; } ),
+        best( [ & ]() {},
+              [ & ]() { beginSnapshot(); } ));
+    endSnapshot();
+
+    report( "replace a weapon per ship, save",
+        best( [ & ]() { weaponCopies = plainWeapons; },
+              [ & ]() { for ( auto& weapons : plainWeapons ) weapons[ 0 ] = weapons[ 1 ]; } ),
+        best( [ & ]() { endSnapshot(); beginSnapshot(); },
+              [ & ]() { for ( auto& weapons : persistentWeapons ) weapons.edit().set( 0, weapons()[ 1 ] ); } ));
+    endSnapshot();
+
+    report( "sweep every list",
+        best( [ & ]() {}, [ & ]() { for ( auto& weapons : plainWeapons ) for ( auto& weapon : weapons ) sum += *weapon; } ),
+        best( [ & ]() {}, [ & ]() { for ( auto& weapons : persistentWeapons ) for ( auto& weapon : weapons() ) sum += *weapon; } ));
+
+    return sum == 0; // keeps the sweeps from being optimized out
+}
@@ -0,0 +1,537 @@
+// snapshot.cpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+//
+// Save engines compared on the same world: per-field Saveable snapshots, a
+// full deep copy serialized off-thread, a forked copy-on-write child, and
+// the double-buffered world (pingpong.hpp), which saves by fork as well.
+//
+//   make bench && bench/snapshot [SHIPS] [SIDE] [TICKS]
+//
+// Defaults to 2000 ships over a 10 x 10 sector universe (SIDE up to 26),
+// every sector watched so every ship is simulated and saved. Each engine
+// runs TICKS ticks without saving, then TICKS more saving back to back --
+// a save starts at the first tick boundary after the last one finished.
+//
+// Prints CSV, one row per engine:
+//   start_ms       tick stall starting a save (mean, then max)
+//   end_ms         tick stall finishing one -- joining, reconciling, reaping
+//   tick_ms        mean tick while a save was in flight
+//   idle_tick_ms   mean tick with none
+//   overhead_ms    the difference
+//   extra_kb       memory a save in flight added, at most -- resident set
+//                  growth, serializer buffers included, or for a fork the
+//                  pages the parent copied on write
+//   save_bytes     size of the latest save
+//   bytes_per_sec  XmlSerializer::savegame throughput, over all saves
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "actions.hpp"
+#include "constants.hpp"
+#include "init.hpp"
+#include "lod.hpp"
+#include "models.hpp"
+#include "pingpong.hpp"
+#include "rand.hpp"
+#include "routes.hpp"
+#include "schedule.hpp"
+#include "traffic.hpp"
+#include "opt/saveable.hpp"
+#include "opt/xmlserializer.hpp"
+
+
+using namespace tinyspace;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+
+namespace {
+
+uint64_t const SEED     = 7;
+size_t   const WARMUP   = 50; // ticks before measuring, so traffic settles
+double   const DELTA    = TICK_TIME / 1000.0;
+long     const PAGE_KB  = 4;
+
+
+enum Engine : unsigned int
+{
+    Engine_Saveable,
+    Engine_DeepCopy,
+    Engine_Fork,
+    Engine_DoubleBuffer,
+    Engine_END
+};
+
+
+string engineName( Engine engine )
+{
+    switch ( engine )
+    {
+        case Engine_Saveable:     return "saveable";
+        case Engine_DeepCopy:     return "deep-copy";
+        case Engine_Fork:         return "fork";
+        case Engine_DoubleBuffer: return "double-buffer";
+        default:                  return "";
+    }
+}
+
+
+double since( steady_clock::time_point start )
+{
+    return duration<double>( steady_clock::now() - start ).count();
+}
+
+long residentKb()
+{
+    long pages = 0, resident = 0;
+    if ( FILE* statm = fopen( "/proc/self/statm", "r" ))
+    {
+        if ( fscanf( statm, "%ld %ld", &pages, &resident ) != 2 ) resident = 0;
+        fclose( statm );
+    }
+    return resident * ( sysconf( _SC_PAGESIZE ) / 1024 );
+}
+
+long minorFaults()
+{
+    struct rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+    return usage.ru_minflt;
+}
+
+
+// The savegame's world and the tick that moves it -- main.cpp's, with every
+// sector watched
+struct World
+{
+    sectors_t     sectors;
+    jumpgates_t   jumpgates;
+    routes_ptr_t  routes;
+    stations_t    stations;
+    ships_t       ships;
+    Schedule      schedule;
+    LevelOfDetail lod;
+    Traffic       traffic;
+    TickBuffers   buffers;
+    sector_ptrs_t watched;
+
+    World( size_t shipCount, size_t side, bool doubleBuffered )
+        : sectors( initSectors( { side, side }, SECTOR_SIZE )),
+          jumpgates( initJumpgates( sectors, true )),
+          routes( initRoutes( sectors )),
+          stations( initStations( sectors )),
+          ships( initShips( shipCount, sectors, true )),
+          schedule( false, true, doubleBuffered ),
+          buffers( doubleBuffered )
+    {
+        for ( auto& row : sectors ) for ( auto& sector : row ) watched.push_back( &sector );
+    }
+
+    void tick()
+    {
+        Ship* player = &ships[ 0 ];
+        schedule.advance( DELTA );
+        lod.update( sectors, watched, DELTA, true );
+        traffic.update( schedule, sectors, lod, player, DELTA, true );
+        respawnShips( schedule, player, stations, true );
+        moveShips( schedule, sectors, player, true );
+        acquireTargets( sectors, schedule );
+        fireWeapons( schedule, sectors );
+        resolveCombat( schedule, sectors );
+    }
+
+    string savegame() const
+    {
+        return XmlSerializer( schedule.time ).savegame( sectors, jumpgates, stations, ships );
+    }
+};
+
+
+// A world's savegame contents, rebuilt with every pointer redirected into
+// the copy -- what the deep copy engine serializes
+struct WorldCopy
+{
+    double      time;
+    sectors_t   sectors;
+    jumpgates_t jumpgates;
+    stations_t  stations;
+    ships_t     ships;
+
+    WorldCopy( World const& world )
+        : time( world.schedule.time )
+    {
+        auto const& from = world;
+
+        // vectors sized up front, so nothing moves once it's pointed at
+        sectors.reserve( from.sectors.size() );
+        for ( auto& row : from.sectors )
+        {
+            sectors.emplace_back();
+            sectors.back().reserve( row.size() );
+            for ( auto& sector : row )
+            {
+                sectors.back().emplace_back( sector.id, sector.rowcol, sector.name, sector.size );
+                sectors.back().back().traffic = sector.traffic();
+            }
+        }
+        auto sectorOf = [ & ]( Sector const* sector ) -> Sector*
+        {
+            return sector ? &sectors[ sector->rowcol.first ][ sector->rowcol.second ] : nullptr;
+        };
+        auto jumpgateOf = [ & ]( Jumpgate const* jumpgate ) -> Jumpgate*
+        {
+            return jumpgate ? &jumpgates[ jumpgate - from.jumpgates.data() ] : nullptr;
+        };
+        auto shipOf = [ & ]( HasIDAndSectorAndPosition const* target ) -> Ship*
+        {
+            auto ship = dynamic_cast<Ship const*>( target );
+            return ship ? &ships[ ship - from.ships.data() ] : nullptr;
+        };
+        auto objectOf = [ & ]( HasIDAndSectorAndPosition* object ) -> HasIDAndSectorAndPosition*
+        {
+            if ( auto jumpgate = dynamic_cast<Jumpgate*>( object )) return jumpgateOf( jumpgate );
+            if ( auto station = dynamic_cast<Station*>( object ))   return &stations[ station - from.stations.data() ];
+            return nullptr;
+        };
+
+        jumpgates.reserve( from.jumpgates.size() );
+        for ( auto& jumpgate : from.jumpgates )
+        {
+            jumpgates.emplace_back( jumpgate.id, sectorOf( jumpgate.sector ), jumpgate.position );
+        }
+        for ( size_t i = 0; i < jumpgates.size(); ++i )
+        {
+            jumpgates[ i ].target = jumpgateOf( from.jumpgates[ i ].target );
+        }
+
+        stations.reserve( from.stations.size() );
+        for ( auto& station : from.stations )
+        {
+            stations.emplace_back( station.id, sectorOf( station.sector ), station.position );
+            stations.back().sector->stations.insert( &stations.back() );
+        }
+
+        for ( size_t row = 0; row < sectors.size(); ++row )
+        {
+            for ( size_t col = 0; col < sectors[ row ].size(); ++col )
+            {
+                auto& gates = from.sectors[ row ][ col ].jumpgates;
+                auto& to    = sectors[ row ][ col ].jumpgates;
+                to.north = jumpgateOf( gates.north );
+                to.east  = jumpgateOf( gates.east );
+                to.south = jumpgateOf( gates.south );
+                to.west  = jumpgateOf( gates.west );
+            }
+        }
+
+        ships.reserve( from.ships.size() );
+        for ( auto& ship : from.ships )
+        {
+            destination_ptr_t destination;
+            if ( auto& dest = ship.destination() )
+            {
+                destination = dest->object
+                            ? destination_ptr_t( new Destination( *objectOf( dest->object )))
+                            : destination_ptr_t( new Destination( *sectorOf( dest->sector ), dest->position ));
+            }
+            ships.emplace_back( ship.id, ship.type, ship.faction, ship.maxHull, ship.currentHull,
+                                ship.code, ship.name, sectorOf( ship.sector ), ship.position,
+                                ship.direction, ship.speed, destination,
+                                nullptr, ship.docked, ship.timeoutAt );
+            Ship& copy = ships.back();
+            copy.origin    = ship.origin;
+            copy.departure = ship.departure;
+            copy.arrival   = ship.arrival;
+            copy.journey   = sectorOf( ship.journey );
+            copy.parked    = ship.parked;
+        }
+
+        for ( size_t i = 0; i < ships.size(); ++i )
+        {
+            Ship const& ship = from.ships[ i ];
+            Ship&       copy = ships[ i ];
+            copy.target = shipOf( ship.target );
+
+            auto arm = [ & ]( weapon_ptrs_pvec_t const& weapons ) -> weapon_ptrs_t
+            {
+                weapon_ptrs_t armed;
+                for ( auto& weapon : weapons )
+                {
+                    armed.emplace_back( new Weapon( weapon->id, weapon->type, weapon->isTurret, weapon->weaponPosition,
+                                                    copy, shipOf( weapon->target ), weapon->readyAt ));
+                }
+                return armed;
+            };
+            copy.setWeapons( arm( ship.weapons ));
+            copy.setTurrets( arm( ship.turrets ));
+        }
+
+        for ( size_t row = 0; row < sectors.size(); ++row )
+        {
+            for ( size_t col = 0; col < sectors[ row ].size(); ++col )
+            {
+                ship_ptrs_set_t roster;
+                for ( Ship* ship : from.sectors[ row ][ col ].ships() ) roster.insert( shipOf( ship ));
+                sectors[ row ][ col ].setShips( std::move( roster ));
+            }
+        }
+    }
+
+    string savegame() const
+    {
+        return XmlSerializer( time ).savegame( sectors, jumpgates, stations, ships );
+    }
+};
+
+
+// One save in flight, however the engine takes it
+struct Save
+{
+    Engine              engine;
+    std::thread*        thread;
+    std::atomic<bool>   done;
+    pid_t               pid;
+    int                 pipe;     // fork -- the child reports its bytes and seconds
+    long                faults;   // fork -- parent minor faults when forked
+    size_t              bytes;
+    double              seconds;  // serializing
+
+    Save( Engine engine )
+        : engine( engine ), thread( nullptr ), done( false ),
+          pid( 0 ), pipe( -1 ), faults( 0 ), bytes( 0 ), seconds( 0.0 )
+    {}
+
+    void start( World& world )
+    {
+        auto serialize = [ this ]( std::function<string()> const& savegame )
+        {
+            auto   start = steady_clock::now();
+            string xml   = savegame();
+            seconds = since( start );
+            bytes   = xml.size();
+        };
+
+        switch ( engine )
+        {
+            case Engine_Saveable:
+                beginSnapshot();
+                thread = new std::thread( [ this, &world, serialize ]()
+                {
+                    SnapshotReader reader;
+                    serialize( [ & ]() { return world.savegame(); } );
+                    done = true;
+                });
+                break;
+
+            case Engine_DeepCopy:
+            {
+                auto copy = new WorldCopy( world );
+                thread = new std::thread( [ this, copy, serialize ]()
+                {
+                    serialize( [ & ]() { return copy->savegame(); } );
+                    delete copy;
+                    done = true;
+                });
+                break;
+            }
+
+            case Engine_Fork:
+            case Engine_DoubleBuffer: // the slots carry each tick's front -- nothing left to save from
+            {
+                int ends[ 2 ];
+                if ( ::pipe( ends ) != 0 )
+                {
+                    perror( "pipe" );
+                    exit( 1 );
+                }
+                faults = minorFaults();
+                pid    = fork();
+                if ( pid == 0 )
+                {
+                    serialize( [ & ]() { return world.savegame(); } );
+                    ssize_t written = write( ends[ 1 ], &bytes, sizeof( bytes ))
+                                    + write( ends[ 1 ], &seconds, sizeof( seconds ));
+                    _exit( written == sizeof( bytes ) + sizeof( seconds ) ? 0 : 1 );
+                }
+                close( ends[ 1 ] );
+                pipe = ends[ 0 ];
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    // At a tick boundary -- true once the save is over and cleaned up
+    bool finish( bool wait )
+    {
+        if ( isForked() )
+        {
+            int status;
+            if ( waitpid( pid, &status, wait ? 0 : WNOHANG ) == 0 )
+            {
+                return false;
+            }
+            if ( read( pipe, &bytes, sizeof( bytes )) != sizeof( bytes )
+            ||   read( pipe, &seconds, sizeof( seconds )) != sizeof( seconds ))
+            {
+                fprintf( stderr, "fork: child failed\n" );
+                exit( 1 );
+            }
+            close( pipe );
+            return true;
+        }
+        if ( ! wait && ( ! done || snapshotReaders ))
+        {
+            return false;
+        }
+        thread->join();
+        delete thread;
+        if ( engine == Engine_Saveable )
+        {
+            endSnapshot();
+        }
+        return true;
+    }
+
+    // Memory the save has cost so far
+    long extraKb( long residentBefore ) const
+    {
+        return isForked() ? ( minorFaults() - faults ) * PAGE_KB : residentKb() - residentBefore;
+    }
+
+    bool isForked() const
+    {
+        return engine == Engine_Fork || engine == Engine_DoubleBuffer;
+    }
+};
+
+
+struct Stats
+{
+    double sum, max;
+    size_t count;
+
+    Stats() : sum( 0.0 ), max( 0.0 ), count( 0 ) {}
+
+    void add( double v ) { sum += v; max = std::max( max, v ); ++count; }
+    double mean() const  { return count ? sum / count : 0.0; }
+};
+
+
+void run( Engine engine, size_t shipCount, size_t side, size_t ticks )
+{
+    seedRand( SEED );
+    World world( shipCount, side, engine == Engine_DoubleBuffer );
+
+    auto tick = [ & ]() -> double
+    {
+        auto start = steady_clock::now();
+        world.tick();
+        world.buffers.swap();
+        return since( start );
+    };
+
+    for ( size_t i = 0; i < WARMUP; ++i )
+    {
+        world.buffers.open();
+        tick();
+    }
+
+    Stats idle;
+    for ( size_t i = 0; i < ticks; ++i )
+    {
+        world.buffers.open();
+        idle.add( tick() );
+    }
+
+    Stats  starts, ends, busy;
+    long   extraKb = 0, residentBefore = 0;
+    size_t saves = 0, bytes = 0;
+    double seconds = 0.0;
+    Save*  save = nullptr;
+    for ( size_t i = 0; i < ticks; ++i )
+    {
+        world.buffers.open();
+        if ( save )
+        {
+            extraKb = std::max( extraKb, save->extraKb( residentBefore ));
+            auto start = steady_clock::now();
+            if ( save->finish( false ))
+            {
+                ends.add( since( start ));
+                ++saves;
+                bytes    = save->bytes;
+                seconds += save->seconds;
+                delete save;
+                save = nullptr;
+            }
+        }
+        if ( ! save )
+        {
+            residentBefore = residentKb();
+            save = new Save( engine );
+            auto start = steady_clock::now();
+            save->start( world );
+            starts.add( since( start ));
+        }
+        busy.add( tick() );
+    }
+    if ( save )
+    {
+        // the last one is waited for -- its stall isn't a tick's
+        save->finish( true );
+        ++saves;
+        bytes    = save->bytes;
+        seconds += save->seconds;
+        delete save;
+    }
+
+    printf( "%s,%zu,%zu,%zu,%zu,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%ld,%zu,%.0f\n",
+        engineName( engine ).c_str(), shipCount, side * side, ticks, saves,
+        starts.mean() * 1000, starts.max * 1000, ends.mean() * 1000,
+        busy.mean() * 1000, idle.mean() * 1000, ( busy.mean() - idle.mean() ) * 1000, busy.max * 1000,
+        extraKb, bytes, seconds > 0.0 ? saves * bytes / seconds : 0.0 );
+    fflush( stdout );
+}
+
+} // anonymous
+
+
+int main( int argc, char** argv )
+{
+    size_t const shipCount = argc > 1 ? strtoul( argv[ 1 ], nullptr, 10 ) : 2000;
+    size_t const side      = std::min<size_t>( std::max<size_t>( argc > 2 ? strtoul( argv[ 2 ], nullptr, 10 ) : 10, 1 ), 26 );
+    size_t const ticks     = argc > 3 ? strtoul( argv[ 3 ], nullptr, 10 ) : 300;
+
+    // the deep copy has to serialize as the world it was taken from
+    {
+        seedRand( SEED );
+        World world( shipCount, side, false );
+        for ( size_t i = 0; i < WARMUP; ++i ) world.tick();
+        if ( WorldCopy( world ).savegame() != world.savegame() )
+        {
+            fprintf( stderr, "deep copy: savegame differs from the world's\n" );
+            return 1;
+        }
+    }
+
+    printf( "engine,ships,sectors,ticks,saves,start_ms,max_start_ms,end_ms,"
+            "tick_ms,idle_tick_ms,overhead_ms,max_tick_ms,extra_kb,save_bytes,bytes_per_sec\n" );
+    for ( unsigned int engine = 0; engine < Engine_END; ++engine )
+    {
+        run( static_cast<Engine>( engine ), shipCount, side, ticks );
+    }
+    return 0;
+}
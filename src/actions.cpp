@@ -8,35 +8,156 @@
 #include <map>
 #include <vector>
 #include "constants.hpp"
+#include "init.hpp"
 #include "models.hpp"
 #include "rand.hpp"
+#include "routes.hpp"
+#include "schedule.hpp"
 
 
 namespace tinyspace {
 
 
-void moveShips(
-    double delta, // seconds
-    ships_t& ships,
-    Ship* playerShip,
-    bool useJumpgates )
+static inline void clearTargets( Ship& ship )
+{
+    if ( ship.target )
+    {
+        ship.target = nullptr;
+    }
+    for ( auto& weapon : ship.weapons() ) if ( weapon->target ) weapon->target = nullptr;
+    for ( auto& turret : ship.turrets() ) if ( turret->target ) turret->target = nullptr;
+}
+
+
+// Moves a ship to another sector -- its targets stay behind
+static void changeSector( Ship& ship, Sector* sector )
+{
+    ship.sector->removeShip( &ship );
+    ship.sector = sector;
+    sector->addShip( &ship );
+    clearTargets( ship );
+}
+
+
+// Handles a ship reaching its destination -- jumps through gates, docks at
+// stations, and picks the next destination. Returns the ship's new sector.
+static Sector* arrive( Ship& ship, Schedule& schedule, double time, bool isPlayerShip, bool useJumpgates )
+{
+    Sector* sector = ship.sector;
+    auto&   pos    = ship.position;
+    auto&   dir    = ship.direction;
+    auto&   dest   = ship.destination;
+
+    pos = dest->currentPosition();
+
+    location_ptrs_t excludes;
+
+    if ( auto jumpgate = dynamic_cast<Jumpgate*>( dest->object ))
+    {
+        sector = jumpgate->target->sector;
+        pos = jumpgate->target->position;
+        excludes.push_back(jumpgate->target);
+    }
+    else if ( dynamic_cast<Station*>( dest->object ))
+    {
+        excludes.insert( excludes.end(), sector->stations.begin(), sector->stations.end() );
+        // reached a station -- dock and repair ship
+        ship.currentHull = ship.maxHull;
+        ship.docked      = true;
+        ship.timeoutAt   = time + DOCK_TIME;
+        schedule.addTimer( ship, TimerType_Undock, ship.timeoutAt );
+        sector->updateShip( &ship );
+    }
+
+    // Follow (or set out on) a multi-sector journey
+    if ( ship.journey == sector )
+    {
+        ship.journey = nullptr;
+    }
+    if ( ship.docked && ! ship.journey && useJumpgates && randFloat() < JOURNEY_CHANCE )
+    {
+        ship.journey = randJourney( *sector );
+    }
+    if ( ship.journey )
+    {
+        if ( Jumpgate* jumpgate = nextJumpgate( *sector, *ship.journey ))
+        {
+            dest = destination_ptr_t( new Destination( *jumpgate ));
+            dir = ( dest->position - pos ).normalized();
+            return sector;
+        }
+        ship.journey = nullptr;
+    }
+
+    float miscChance = isPlayerShip && sector->jumpgates.count() > 1 ? 0.f : MISC_DESTINATION_CHANCE;
+    if ( dest->object )
+    {
+        dest = randDestination( *sector, useJumpgates, miscChance, &excludes );
+        dir = ( dest->position - pos ).normalized();
+    }
+    else
+    {
+        dest = randDestination( *sector, useJumpgates, miscChance );
+    }
+
+    return sector;
+}
+
+
+// Releases ships whose dock timers fired this tick
+static void undockShips( Schedule& schedule, bool useJumpgates )
 {
-    std::map<Sector*, ship_ptrs_set_t> sectorShipRefs;
-    
-    for ( auto& ship : ships )
+    for ( auto& timer : schedule.expired )
     {
-        if ( ship.timeout )
+        Ship& ship = *timer.ship;
+        if ( timer.type != TimerType_Undock || ! ship.docked || ship.timeoutAt != timer.time )
         {
-            ship.timeout = std::max( 0.0, ship.timeout - delta );
+            continue;
         }
-        if ( ship.docked && !ship.timeout )
+        ship.docked = false;
+        ship.sector->updateShip( &ship );
+
+        if ( schedule.kinetic )
         {
-            ship.docked = false;
+            // Undocked or respawned -- set out for the destination
+            if ( ! ship.destination || ship.destination->currentSector() != ship.sector )
+            {
+                ship.destination = randDestination( *ship.sector, useJumpgates );
+            }
+            schedule.depart( ship, timer.time );
         }
-        if ( ship.docked || ship.currentHull <= 0 || ship.timeout )
+    }
+}
+
+
+// Integrates every flying ship in a due sector over the sector's accrued delta
+static void integrateShips(
+    Schedule& schedule,
+    sectors_t& sectors,
+    Ship* playerShip,
+    bool useJumpgates )
+{
+    // Only flying ships in due sectors move -- gather them up front, since
+    // docking and sector changes re-file ships while we iterate
+    ship_ptrs_t flying;
+    for ( auto& sectorRow : sectors )
+    {
+        for ( auto& sector : sectorRow )
         {
-            continue;
+            if ( ! sector.lod.due ) continue;
+            for ( size_t faction = 0; faction < ShipFaction_END; ++faction )
+            {
+                auto& ships = sector.stateShips( ShipState_Flying, static_cast<ShipFaction>( faction ));
+                flying.insert( flying.end(), ships.begin(), ships.end() );
+            }
         }
+    }
+
+    for ( auto shipPtr : flying )
+    {
+        Ship& ship = *shipPtr;
+
+        double const delta = ship.sector->lod.delta; // seconds
 
         bool    isPlayerShip = &ship == playerShip;
         Sector* sector       = ship.sector;
@@ -60,35 +181,7 @@ void moveShips(
             else
             {
                 // Reached the destination
-                pos = destPos;
-
-                location_ptrs_t excludes;
-
-                if ( auto jumpgate = dynamic_cast<Jumpgate*>( dest->object ))
-                {
-                    sector = jumpgate->target->sector;
-                    pos = jumpgate->target->position;
-                    excludes.push_back(jumpgate->target);
-                }
-                else if ( dynamic_cast<Station*>( dest->object ))
-                {
-                    excludes.insert( excludes.end(), sector->stations.begin(), sector->stations.end() );
-                    // reached a station -- dock and repair ship
-                    ship.currentHull = ship.maxHull;
-                    ship.docked      = true;
-                    ship.timeout     = DOCK_TIME; // dock timer
-                }
-
-                float miscChance = isPlayerShip && sector->jumpgates.count() > 1 ? 0.f : MISC_DESTINATION_CHANCE;
-                if ( dest->object )
-                {
-                    dest = randDestination( *sector, useJumpgates, miscChance, &excludes );
-                    dir = ( dest->position - pos ).normalized();
-                }
-                else
-                {
-                    dest = randDestination( *sector, useJumpgates, miscChance );
-                }
+                sector = arrive( ship, schedule, schedule.time, isPlayerShip, useJumpgates );
             }
         }
         else
@@ -114,7 +207,7 @@ void moveShips(
                 if ( sector->neighbors.west )
                 {
                     sector = sector->neighbors.west;
-                    pos = {pos.x + sector->size.x, pos.y};
+                    pos = position_t{ pos.x + sector->size.x, pos.y };
                 }
                 else
                 {
@@ -125,7 +218,7 @@ void moveShips(
             {
                 if ( sector->neighbors.east )
                 {
-                    pos = { pos.x - sector->size.x, pos.y };
+                    pos = position_t{ pos.x - sector->size.x, pos.y };
                     sector = sector->neighbors.east;
                 }
                 else
@@ -138,7 +231,7 @@ void moveShips(
                 if ( sector->neighbors.north )
                 {
                     sector = sector->neighbors.north;
-                    pos = { pos.x, pos.y + sector->size.y };
+                    pos = position_t{ pos.x, pos.y + sector->size.y };
                 }
                 else
                 {
@@ -149,7 +242,7 @@ void moveShips(
             {
                 if ( sector->neighbors.south )
                 {
-                    pos = { pos.x, pos.y - sector->size.y };
+                    pos = position_t{ pos.x, pos.y - sector->size.y };
                     sector = sector->neighbors.south;
                 }
                 else
@@ -162,20 +255,7 @@ void moveShips(
         // Handle sector changes
         if ( sector != ship.sector )
         {
-            // remove from old sector
-            if ( ! sectorShipRefs.count( ship.sector ))
-            {
-                sectorShipRefs[ ship.sector ] = ship_ptrs_set_t( ship.sector->ships );
-            }
-            sectorShipRefs[ ship.sector ].erase( &ship );
-            // add to new sector
-            if ( ! sectorShipRefs.count( sector ))
-            {
-                sectorShipRefs[ sector ] = ship_ptrs_set_t( sector->ships );
-            }
-            sectorShipRefs[ sector ].insert( &ship );
-            // update ship
-            ship.sector = sector;
+            changeSector( ship, sector );
         }
 
         // Maintain sector boundary
@@ -184,85 +264,191 @@ void moveShips(
         if      ( pos.y < 0 )              pos.y = 0;
         else if ( pos.y > sector->size.y ) pos.y = sector->size.y;
     }
-    
-    // Update sector ships
-    for ( auto& sectorShipRef : sectorShipRefs )
+}
+
+
+// Kinetic mode -- ships fly straight legs evaluated lazily from their
+// trajectory, so per-tick work is limited to departures and arrivals
+static void advanceShips(
+    Schedule& schedule,
+    Ship* playerShip,
+    bool useJumpgates )
+{
+    double const time = schedule.time;
+
+    auto& arrivals = schedule.arrivals;
+    while ( ! arrivals.empty() && arrivals.top().time <= time )
     {
-        sectorShipRef.first->setShips( std::move( sectorShipRef.second ));
+        double arrivalTime = arrivals.top().time;
+        Ship&  ship        = *arrivals.top().ship;
+        arrivals.pop();
+
+        // Skip arrivals superseded by a newer leg, death, or respawn
+        if ( ! ship.inFlight() || ship.arrival != arrivalTime )
+        {
+            continue;
+        }
+        ship.stop( arrivalTime );
+
+        Sector* sector = arrive( ship, schedule, arrivalTime, &ship == playerShip, useJumpgates );
+        if ( sector != ship.sector )
+        {
+            changeSector( ship, sector );
+        }
+        if ( ! ship.docked )
+        {
+            schedule.depart( ship, arrivalTime );
+        }
     }
 }
 
 
-void acquireTargets( Sector& sector )
+void moveShips(
+    Schedule& schedule,
+    sectors_t& sectors,
+    Ship* playerShip,
+    bool useJumpgates )
 {
-    std::map<Ship*, ship_ptrs_t> potentialTargets;
-    ship_ptrs_t sectorShips;
-    sectorShips.reserve( sector.ships.size() );
+    undockShips( schedule, useJumpgates );
+
+    if ( schedule.kinetic )
+    {
+        advanceShips( schedule, playerShip, useJumpgates );
+    }
+    else
+    {
+        integrateShips( schedule, sectors, playerShip, useJumpgates );
+    }
+}
+
+
+void syncPositions( Sector& sector, double time )
+{
+    for ( Ship* ship : sector.ships() )
+    {
+        ship->syncPosition( time );
+    }
+}
+
 
-    for ( Ship* ship : sector.ships )
+// Sectors below full detail resolve combat in aggregate (see resolveCombat) --
+// coarsened to all but the watched sectors when shedding load (see budget.hpp)
+static inline bool isShotByShot( Schedule const& schedule, Sector const& sector )
+{
+    if ( schedule.coarseCombat )
     {
-        // Clear dead ships' targets
-        if ( ship->currentHull <= 0.f )
+        return sector.lod.distance == 0;
+    }
+    return ! schedule.statisticalCombat || sector.lod.tier == LodTier_Full;
+}
+
+
+// Another ship's hull and docking as combat sees them -- as the tick began
+// when double buffered (pingpong.hpp), so no ship's shots or kills this tick
+// change what another ship sees
+static inline unsigned int seenHull( Ship const& ship, bool fromFront )
+{
+    return fromFront ? ship.currentHull.snap() : ship.currentHull();
+}
+
+static inline bool seenDocked( Ship const& ship, bool fromFront )
+{
+    return fromFront ? ship.docked.snap() : ship.docked();
+}
+
+
+// Marks a ship dead and arms its respawn timer
+static void killShip( Schedule& schedule, Ship& ship, double time )
+{
+    ship.currentHull = 0;
+    ship.timeoutAt   = time + RESPAWN_TIME;
+    ship.stop( time );
+    ship.sector->updateShip( &ship );
+    clearTargets( ship );
+    schedule.addTimer( ship, TimerType_Respawn, ship.timeoutAt );
+}
+
+
+void acquireTargets( Sector& sector, double time, bool fromFront )
+{
+    // Uncontested sectors skip targeting entirely -- targets left from the
+    // last contested tick are cleared once
+    if ( ! sector.isContested() )
+    {
+        if ( sector.isTargeting )
         {
-            if ( ship->target )
+            for ( Ship* ship : sector.ships() )
             {
-                ship->target = nullptr;
-            }
-            for ( auto weapon : ship->weaponsAndTurrets() )
-            {
-                if ( weapon->target )
-                {
-                    weapon->target = nullptr;
-                }
+                clearTargets( *ship );
             }
-            continue;
+            sector.isTargeting = false;
         }
-        // Exclude neutral ships
-        if ( ! ship->faction )
+        return;
+    }
+    sector.isTargeting = true;
+
+    std::map<Ship*, ship_ptrs_t> potentialTargets;
+    ship_ptrs_t  factionShips[ ShipFaction_END ];
+    unsigned int factionsPresent = sector.factionsPresent();
+
+    for ( size_t faction = 0; faction < ShipFaction_END; ++faction )
+    {
+        // Live ships only -- dead ships had their targets cleared when killed
+        auto& flying = sector.stateShips( ShipState_Flying, static_cast<ShipFaction>( faction ));
+        auto& docked = sector.stateShips( ShipState_Docked, static_cast<ShipFaction>( faction ));
+        factionShips[ faction ].reserve( flying.size() + docked.size() );
+        factionShips[ faction ].insert( factionShips[ faction ].end(), flying.begin(), flying.end() );
+        factionShips[ faction ].insert( factionShips[ faction ].end(), docked.begin(), docked.end() );
+    }
+
+    // Kinetic ships only carry their trajectory -- bring positions up to date
+    for ( auto& ships : factionShips )
+    {
+        for ( Ship* ship : ships )
         {
-            continue;
+            ship->syncPosition( time );
         }
-        sectorShips.push_back( ship );
     }
 
-    // Map targets potentially in range
-    for ( Ship* ship : sectorShips )
+    // Map targets potentially in range -- only hostile factions' lists are visited
+    for ( size_t faction = 0; faction < ShipFaction_END; ++faction )
     {
-        if ( ! ship->weapons.empty() || !ship->turrets.empty() )
+        unsigned int hostile = FACTION_HOSTILITY[ faction ] & factionsPresent;
+        for ( Ship* ship : factionShips[ faction ] )
         {
-            for ( Ship* otherShip : sectorShips )
+            if ( hostile && ( ! ship->weapons->empty() || ! ship->turrets->empty() ))
             {
-                // Exclude friendly ships, docked ships, dead ships, and ones definitely out of range
-                if ( ship == otherShip
-                ||   otherShip->docked
-                ||   otherShip->currentHull <= 0.f
-                ||   ship->faction == otherShip->faction
-                ||   ( ship->faction == ShipFaction_Player && otherShip->faction == ShipFaction_Friend )
-                ||   ( ship->faction == ShipFaction_Friend && otherShip->faction == ShipFaction_Player )
-                ||   ( otherShip->position - ship->position ).magnitude() > MAX_TO_HIT_RANGE )
+                for ( size_t otherFaction = 0; otherFaction < ShipFaction_END; ++otherFaction )
                 {
-                    continue;
-                }
+                    if ( ! ( hostile & factionBit( static_cast<ShipFaction>( otherFaction ))))
+                    {
+                        continue;
+                    }
+                    for ( Ship* otherShip : factionShips[ otherFaction ] )
+                    {
+                        // Exclude docked or dead ships and ones definitely out of range
+                        if ( seenDocked( *otherShip, fromFront ) || seenHull( *otherShip, fromFront ) <= 0
+                        ||   ( otherShip->position - ship->position ).magnitudeSquared() > MAX_TO_HIT_RANGE_SQUARED )
+                        {
+                            continue;
+                        }
 
-                if ( ! potentialTargets.count( ship ))
-                {
-                    potentialTargets.emplace( ship, std::move( vector<Ship*>{ otherShip } ));
-                }
-                else
-                {
-                    potentialTargets[ ship ].push_back( otherShip );
+                        if ( ! potentialTargets.count( ship ))
+                        {
+                            potentialTargets.emplace( ship, std::move( vector<Ship*>{ otherShip } ));
+                        }
+                        else
+                        {
+                            potentialTargets[ ship ].push_back( otherShip );
+                        }
+                    }
                 }
             }
-        }
-        // Untarget all if no potential targets are in range
-        if ( ! potentialTargets.count( ship ))
-        {
-            if ( ship->target )
+            // Untarget all if no potential targets are in range
+            if ( ! potentialTargets.count( ship ))
             {
-                ship->target = nullptr;
+                clearTargets( *ship );
             }
-            for ( auto& weapon : ship->weapons ) if ( weapon->target ) weapon->target = nullptr;
-            for ( auto& turret : ship->turrets ) if ( turret->target ) turret->target = nullptr;
         }
     }
 
@@ -288,11 +474,11 @@ void acquireTargets( Sector& sector )
             }
 
             // main weapons
-            for ( size_t i=0; i < ship->weapons.size(); ++i )
+            for ( size_t i=0; i < ship->weapons->size(); ++i )
             {
-                Weapon& weapon = *( ship->weapons[ i ] );
+                Weapon& weapon = *( ship->weapons()[ i ] );
                 WeaponPosition weaponPosition = isShipSideFire( ship->type )
-                                              ? ( i < ship->weapons.size()/2 )
+                                              ? ( i < ship->weapons->size()/2 )
                                                   ? WeaponPosition_Port
                                                   : WeaponPosition_Starboard
                                               : WeaponPosition_Bow;
@@ -313,9 +499,9 @@ void acquireTargets( Sector& sector )
                 }
             }
             // turrets
-            for ( size_t i=0; i < ship->turrets.size(); ++i )
+            for ( size_t i=0; i < ship->turrets->size(); ++i )
             {
-                Weapon& turret = *( ship->turrets[ i ] );
+                Weapon& turret = *( ship->turrets()[ i ] );
                 float toHit = chanceToHit( turret, true, WeaponPosition_Bow, target );
                 if ( toHit > 0.f )
                 {
@@ -338,26 +524,26 @@ void acquireTargets( Sector& sector )
         if ( ship->type >= ShipType_Scout ) // only military ships have primary targets
         {
             Ship* bestTarget = nullptr;
-            distance_t distanceToBestTarget = 0;
-            distance_t distanceToTarget;
+            distance_t distanceToBestTarget = 0; // squared
+            distance_t distanceToTarget;         // squared
             for ( auto target : possibleMainTargets )
             {
                 if ( ! bestTarget )
                 {
                     bestTarget = target;
-                    distanceToBestTarget = ( target->position - ship->position ).magnitude();
+                    distanceToBestTarget = ( target->position - ship->position ).magnitudeSquared();
                 }
-                else if ( target->currentHull != bestTarget->currentHull )
+                else if ( seenHull( *target, fromFront ) != seenHull( *bestTarget, fromFront ))
                 {
-                    if ( target->currentHull < bestTarget->currentHull )
+                    if ( seenHull( *target, fromFront ) < seenHull( *bestTarget, fromFront ))
                     {
                         bestTarget = target;
-                        distanceToBestTarget = ( target->position - ship->position ).magnitude();
+                        distanceToBestTarget = ( target->position - ship->position ).magnitudeSquared();
                     }
                 }
                 else
                 {
-                    distanceToTarget = ( target->position - ship->position ).magnitude();
+                    distanceToTarget = ( target->position - ship->position ).magnitudeSquared();
                     if ( distanceToTarget < distanceToBestTarget )
                     {
                         bestTarget = target;
@@ -375,7 +561,7 @@ void acquireTargets( Sector& sector )
         {
             Ship* bestTarget;
             Weapon* p;
-            for ( auto& weapon : ship->weapons )
+            for ( auto& weapon : ship->weapons() )
             {
                 p = &*weapon;
                 bestTarget = nullptr;
@@ -388,7 +574,7 @@ void acquireTargets( Sector& sector )
                     p->target = bestTarget;
                 }
             }
-            for ( auto& turret : ship->turrets )
+            for ( auto& turret : ship->turrets() )
             {
                 p = &*turret;
                 bestTarget = nullptr;
@@ -406,160 +592,274 @@ void acquireTargets( Sector& sector )
 }
 
 
-void acquireTargets( sectors_t& sectors )
+void acquireTargets( sectors_t& sectors, Schedule const& schedule )
 {
     for ( auto& sectorRow : sectors )
     {
         for ( auto& sector : sectorRow )
         {
-            acquireTargets( sector );
+            if ( sector.lod.due && isShotByShot( schedule, sector ))
+            {
+                acquireTargets( sector, schedule.time, schedule.doubleBuffered );
+            }
         }
     }
 }
 
 
 void fireWeapons(
-    double delta, //seconds
-    ships_t& ships )
+    Schedule& schedule,
+    sectors_t& sectors )
 {
-    std::map<Weapon*, float> weaponCooldowns; // weapon and interative cooldown
-    vector<pair<Weapon*, float>> shots;  // weapon and snapshot cooldown 
+    double const time      = schedule.time;
+    bool const   fromFront = schedule.doubleBuffered;
+    vector<pair<Weapon*, double>> shots; // weapon and sim time of the shot
 
-    // queue shots
+    // queue shots -- each weapon fires on its own cadence from when it's ready
+    auto queueShots = [ & ]( weapon_ptrs_pvec_t const& weapons, double start )
+    {
+        for ( auto& weapon : weapons )
+        {
+            if ( ! weapon->target || weapon->target->sector != weapon->parent->sector )
+            {
+                continue;
+            }
+            double cooldown = weaponCooldown( weapon->type );
+            double shotTime = std::max( weapon->readyAt(), start );
+            if ( cooldown <= 0.0 )
+            {
+                // continuous fire -- a single shot covers the rest of the tick
+                if ( shotTime < time )
+                {
+                    shots.push_back( { &*weapon, shotTime } );
+                    weapon->readyAt = time;
+                }
+                continue;
+            }
+            for ( ; shotTime <= time; shotTime += cooldown )
+            {
+                shots.push_back( { &*weapon, shotTime } );
+            }
+            weapon->readyAt = shotTime;
+        }
+    };
+    for ( auto& sectorRow : sectors )
     {
-        float minNextCooldown = 0.f;
-        bool minNextCooldownSet = false;
-        do
+        for ( auto& sector : sectorRow )
         {
-            weapon_ptrs_t weaponsAndTurrets;
-            for ( auto& ship : ships )
+            // ships in due sectors catch up over the sector's accrued delta
+            if ( ! sector.isContested() || ! sector.lod.due || ! isShotByShot( schedule, sector ))
             {
-                weaponsAndTurrets = ship.weaponsAndTurrets();
-                for ( auto weaponsIt = weaponsAndTurrets.begin(); weaponsIt != weaponsAndTurrets.end(); ++weaponsIt )
+                continue;
+            }
+            // dead ships are skipped -- their partitions aren't visited
+            for ( ShipState state : { ShipState_Flying, ShipState_Docked } )
+            {
+                for ( size_t faction = 0; faction < ShipFaction_END; ++faction )
                 {
-                    auto weapon = &**weaponsIt;
-                    if ( weapon->target )
+                    for ( Ship* ship : sector.stateShips( state, static_cast<ShipFaction>( faction )))
                     {
-                        if ( weapon->target->sector != weapon->parent->sector )
-                        {
-                            return;
-                        }
-                        if ( ! weaponCooldowns.count(weapon))
-                        {
-                            weaponCooldowns[weapon] = weapon->cooldown;
-                        }
-                        auto& currentCooldown = weaponCooldowns[weapon];
-                        if ( currentCooldown <= delta )
-                        {
-                            shots.push_back( { weapon, currentCooldown } );
-                            currentCooldown += weaponCooldown( weapon->type );
-                            if ( ! minNextCooldownSet || currentCooldown < minNextCooldown )
-                            {
-                                minNextCooldown = currentCooldown;
-                                minNextCooldownSet = true;
-                            }
-                        }
+                        queueShots( ship->weapons, time - sector.lod.delta );
+                        queueShots( ship->turrets, time - sector.lod.delta );
                     }
                 }
-                minNextCooldownSet = false;
             }
         }
-        while ( minNextCooldown < delta && minNextCooldown > 0.f );
     }
 
     // sort shot order
-    sort( shots.begin(),
+    std::stable_sort( shots.begin(),
           shots.end(),
-          []( pair<Weapon*, float> a, pair<Weapon*, float> b ) -> bool { return a.second < b.second; } );
+          []( pair<Weapon*, double> const& a, pair<Weapon*, double> const& b ) -> bool { return a.second < b.second; } );
 
     // apply shots
-    if ( shots.size() )
+    for ( auto& shot : shots )
     {
-        float currentCooldown = 0.f;
-        float appliedDelta    = 0.f;
-        bool canFire          = true;
-        for ( size_t i=0; i<shots.size(); ++i )
+        Weapon* weapon   = shot.first;
+        double  shotTime = shot.second;
+
+        auto target = dynamic_cast<Ship*>( weapon->target() );
+        if ( ! target || seenDocked( *target, fromFront ) || seenHull( *target, fromFront ) <= 0 )
+        {
+            continue;
+        }
+        if ( fromFront )
         {
-            do
+            // simultaneous -- ships alive as the tick began fire all their
+            // rounds, and a ship already killed this tick takes no more
+            if ( target->currentHull <= 0 )
             {
-                auto& shot     = shots[ i ];
-                auto  weapon   = shot.first;
-                auto& cooldown = shot.second;
+                continue;
+            }
+        }
+        else if ( Ship* ship = dynamic_cast<Ship*>( weapon->parent ))
+        {
+            // ship is dead -- only rounds fired by the time it was killed are expended
+            if ( ship->currentHull <= 0 && shotTime + RESPAWN_TIME > ship->timeoutAt )
+            {
+                continue;
+            }
+        }
 
-                if ( cooldown != currentCooldown )
+        float toHit = chanceToHit( *weapon, weapon->isTurret, weapon->weaponPosition );
+        if ( toHit <= 0.f || randFloat() > toHit )
+        {
+            continue;
+        }
+
+        auto damage = weaponDamage( weapon->type, weapon->isTurret );
+        if ( isWeaponDamageOverTime( weapon->type ))
+        {
+            // adjust beam weapon damage
+            damage *= time - shotTime;
+        }
+        target->currentHull = std::max( 0.f, target->currentHull - damage );
+        if ( target->currentHull <= 0 )
+        {
+            killShip( schedule, *target, shotTime );
+        }
+    }
+}
+
+
+// Expected damage per second one ship deals another, by ship types -- side
+// fire ships only bring one broadside to bear
+static float shipDps( ShipType shipType, ShipType targetType )
+{
+    static vector<float> const table = []()
+    {
+        vector<float> table( ShipType_END * ShipType_END, 0.f );
+        for ( size_t shipType = 0; shipType < ShipType_END; ++shipType )
+        {
+            for ( size_t targetType = 0; targetType < ShipType_END; ++targetType )
+            {
+                auto target = shipTypeToTargetType( static_cast<ShipType>( targetType ));
+                auto dps = [ target ]( WeaponType weapon, bool isTurret ) -> float
+                {
+                    float damage = weaponDamage( weapon, isTurret ) * HIT_CHANCE[ weapon ][ isTurret ][ target ].accuracy;
+                    return isWeaponDamageOverTime( weapon ) ? damage : damage / weaponCooldown( weapon );
+                };
+                float& total = table[ shipType * ShipType_END + targetType ];
+                for ( auto weapon : shipWeapons( static_cast<ShipType>( shipType ))) total += dps( weapon, false );
+                for ( auto turret : shipTurrets( static_cast<ShipType>( shipType ))) total += dps( turret, true );
+            }
+        }
+        return table;
+    }();
+    return table[ shipType * ShipType_END + targetType ];
+}
+
+
+// Lanchester-style attrition -- each faction's expected damage against each
+// hostile faction comes from the ship type tables, with every ship's fire
+// spread over all hostile ships present. Losses are concentrated from one
+// randomly chosen ship onward, the single draw for the sector.
+static void resolveSectorCombat( Schedule& schedule, Sector& sector )
+{
+    if ( ! sector.isContested() )
+    {
+        return;
+    }
+
+    size_t       shipCounts[ ShipFaction_END ][ ShipType_END ] = {};
+    size_t       factionCounts[ ShipFaction_END ] = {};
+    unsigned int factionsPresent = 0;
+
+    for ( size_t faction = 0; faction < ShipFaction_END; ++faction )
+    {
+        for ( Ship* ship : sector.stateShips( ShipState_Flying, static_cast<ShipFaction>( faction )))
+        {
+            ++shipCounts[ faction ][ ship->type ];
+            ++factionCounts[ faction ];
+        }
+        if ( factionCounts[ faction ] )
+        {
+            factionsPresent |= factionBit( static_cast<ShipFaction>( faction ));
+        }
+    }
+
+    // expected damage taken per faction over the sector's delta
+    float damage[ ShipFaction_END ] = {};
+    bool  isContested = false;
+    for ( size_t faction = 0; faction < ShipFaction_END; ++faction )
+    {
+        unsigned int hostile = FACTION_HOSTILITY[ faction ] & factionsPresent;
+        if ( ! hostile || ! factionCounts[ faction ] )
+        {
+            continue;
+        }
+        isContested = true;
+
+        size_t hostileCount = 0;
+        for ( size_t other = 0; other < ShipFaction_END; ++other )
+        {
+            if ( hostile & factionBit( static_cast<ShipFaction>( other ))) hostileCount += factionCounts[ other ];
+        }
+        for ( size_t other = 0; other < ShipFaction_END; ++other )
+        {
+            if ( ! ( hostile & factionBit( static_cast<ShipFaction>( other ))))
+            {
+                continue;
+            }
+            float dps = 0.f;
+            for ( size_t shipType = 0; shipType < ShipType_END; ++shipType )
+            {
+                if ( ! shipCounts[ faction ][ shipType ] ) continue;
+                for ( size_t targetType = 0; targetType < ShipType_END; ++targetType )
                 {
-                    appliedDelta    = currentCooldown;
-                    currentCooldown = shot.second;
-                    continue;
+                    if ( ! shipCounts[ other ][ targetType ] ) continue;
+                    dps += shipCounts[ faction ][ shipType ] * shipCounts[ other ][ targetType ]
+                         * shipDps( static_cast<ShipType>( shipType ), static_cast<ShipType>( targetType ));
                 }
-                if ( auto target = dynamic_cast<Ship*>( weapon->target ))
-                {
-                    canFire = !target->docked && target->currentHull >= 0;
-                    if ( canFire )
-                    {
-                        if ( Ship* ship = dynamic_cast<Ship*>( weapon->parent ))
-                        {
-                            if ( ship->currentHull <= 0.f )
-                            {
-                                // ship is dead
-                                if ( cooldown > appliedDelta )
-                                {
-                                    // live fire rounds are expended
-                                    canFire = false;
-                                }
-                            }
-                        }
+            }
+            damage[ other ] += dps / hostileCount * AGGREGATE_ENGAGEMENT * sector.lod.delta;
+        }
+    }
+    if ( ! isContested )
+    {
+        return;
+    }
 
-                        if ( canFire)
-                        {
-                            float toHit = chanceToHit( *weapon, weapon->isTurret, weapon->weaponPosition );
-                            if ( toHit <= 0.f )
-                            {
-                                canFire = false;
-                            }
-
-                            if ( canFire )
-                            {
-                                float tryFire = randFloat();
-                                if ( tryFire <= toHit )
-                                {
-                                    auto damage = weaponDamage( weapon->type, weapon->isTurret );
-                                    if ( isWeaponDamageOverTime( weapon->type ))
-                                    {
-                                        // adjust beam weapon damage
-                                        damage *= cooldown - appliedDelta;
-                                    }
-                                    if ( auto target = dynamic_cast<Ship*>( weapon->target ))
-                                    {
-                                        target->currentHull = std::max( 0.f, target->currentHull - damage );
-                                        if ( target->currentHull <= 0 )
-                                        {
-                                            // respawn timer
-                                            target->timeout = RESPAWN_TIME;
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-                ++i;
+    // distribute losses
+    float draw = randFloat();
+    for ( size_t faction = 0; faction < ShipFaction_END; ++faction )
+    {
+        // copied -- kills move ships out of the flying partition
+        ship_ptrs_t ships = sector.stateShips( ShipState_Flying, static_cast<ShipFaction>( faction ));
+        float remaining   = damage[ faction ];
+        size_t first      = static_cast<size_t>( draw * ships.size() );
+        for ( size_t i = 0; i < ships.size() && remaining > 0.f; ++i )
+        {
+            Ship* ship = ships[ ( first + i ) % ships.size() ];
+            float hull = ship->currentHull;
+            ship->currentHull = std::max( 0.f, hull - remaining );
+            remaining -= hull;
+            if ( ship->currentHull <= 0 )
+            {
+                killShip( schedule, *ship, schedule.time );
             }
-            while ( currentCooldown >= appliedDelta && i < shots.size() );
         }
     }
+}
+
 
-    // Update live weapon cooldowns
-    for ( auto& ship : ships )
+void resolveCombat( Schedule& schedule, sectors_t& sectors )
+{
+    for ( auto& sectorRow : sectors )
     {
-        for ( auto& weapon : ship.weapons ) if (weapon->cooldown > 0.f) weapon->cooldown -= delta;
-        for ( auto& turret : ship.turrets ) if (turret->cooldown > 0.f) turret->cooldown -= delta;
+        for ( auto& sector : sectorRow )
+        {
+            if ( sector.lod.due && ! isShotByShot( schedule, sector ))
+            {
+                resolveSectorCombat( schedule, sector );
+            }
+        }
     }
 }
 
 
 void respawnShips(
-    ships_t& ships,
+    Schedule& schedule,
     Ship* playerShip,
     stations_t& stations,
     bool useJumpgates )
@@ -569,28 +869,25 @@ void respawnShips(
         return; // return if there are no valid respawn points
     }
 
-    std::map<Sector*, ship_ptrs_set_t> sectorShipRefs;
-    
-    for ( auto& ship : ships )
+    for ( auto& timer : schedule.expired )
     {
+        Ship& ship        = *timer.ship;
         bool isPlayerShip = &ship == playerShip;
-        if ( ship.currentHull <= 0 && ship.timeout <= 0.f )
+        if ( timer.type == TimerType_Respawn && ship.currentHull <= 0 && ship.timeoutAt == timer.time )
         {
             // don't respawn ships that are dead in the player's sector
             if ( playerShip && ! isPlayerShip && ship.sector == playerShip->sector )
             {
+                ship.timeoutAt = schedule.time + RESPAWN_RETRY_TIME;
+                schedule.addTimer( ship, TimerType_Respawn, ship.timeoutAt );
                 continue;
             }
 
             // remove dead ship from the sector
-            if ( ! sectorShipRefs.count( ship.sector )) 
-            {
-                sectorShipRefs[ ship.sector ] = ship_ptrs_set_t( ship.sector->ships );
-            }
-            sectorShipRefs[ ship.sector ].erase( &ship );
+            ship.sector->removeShip( &ship );
 
             // select a random station for respawn
-            Station& station = stations[ rand() % stations.size() ];
+            Station& station = stations[ randInt() % stations.size() ];
 
             // redefine the ship from scratch
             Sector& sector = *station.sector;
@@ -598,10 +895,8 @@ void respawnShips(
             auto hull      = shipHull(type);
             auto code      = randCode();
             auto name      = randName(type);
-            auto pos       = station.position;
+            auto pos       = station.position();
             auto speed     = shipSpeed(type);
-            auto weapons   = shipWeapons(type);
-            auto turrets   = shipTurrets(type);
 
             // determine a travel destination for after undocking
             vector<HasSectorAndPosition*> excludes{ &station };
@@ -611,32 +906,11 @@ void respawnShips(
 
             // replace dead ship, docked at selected station
             ship = Ship( type, hull, code, name, &sector, pos, dir, speed, dest );
-            ship.docked = true;
-            ship.timeout = 0.f;
-
-            // weapons/turrets
-            weapon_ptrs_t newWeapons;
-            weapon_ptrs_t newTurrets;
-            newWeapons.reserve( weapons.size() );
-            newTurrets.reserve( turrets.size() );
-            bool isSideFire = isShipSideFire(type);
-            for (size_t i = 0; i < ( isSideFire ? 2 : 1 ); ++i)
-            {
-                for ( WeaponType weapon : weapons )
-                {
-                    WeaponPosition weaponPosition = isSideFire
-                                                  ? i ? WeaponPosition_Port
-                                                      : WeaponPosition_Starboard
-                                                  : WeaponPosition_Bow;
-                    newWeapons.emplace( newWeapons.end(), weapon_ptr_t( new Weapon(weapon, false, weaponPosition, ship )));
-                }
-            }
-            for ( WeaponType turret : turrets )
-            {
-                newTurrets.emplace( newTurrets.end(), weapon_ptr_t( new Weapon( turret, true, WeaponPosition_Bow, ship )));
-            }
-            ship.setWeapons( std::move( newWeapons ));
-            ship.setTurrets( std::move( newTurrets ));
+            ship.docked    = true;
+            ship.timeoutAt = schedule.time; // undock next tick
+            schedule.addTimer( ship, TimerType_Undock, ship.timeoutAt );
+
+            armShip( ship );
 
             // friend/foe
             if ( isPlayerShip )
@@ -664,19 +938,9 @@ void respawnShips(
             }
 
             // add to respawn sector
-            if ( ! sectorShipRefs.count( &sector ))
-            {
-                sectorShipRefs[ &sector ] = ship_ptrs_set_t( sector.ships );
-            }
-            sectorShipRefs[ &sector ].insert( &ship );
+            sector.addShip( &ship );
         }
     }
-    
-    // Update sector ships
-    for ( auto& sectorShipRef : sectorShipRefs )
-    {
-        sectorShipRef.first->setShips( std::move( sectorShipRef.second ));
-    }
 }
 
 
@@ -12,21 +12,34 @@
 namespace tinyspace {
 
 
+// Moves ships in sectors due this tick (see lod.hpp) -- kinetic ships are
+// event-driven and always advance
 void moveShips(
-    double delta, // seconds
-    ships_t& ships,
+    Schedule& schedule,
+    sectors_t& sectors,
     Ship* playerShip,
     bool useJumpgates );
 
-void acquireTargets( Sector& sector );
-void acquireTargets( sectors_t& sectors );
+// Brings kinetic ships' stored positions up to the given sim time
+void syncPositions( Sector& sector, double time );
 
+// Ships see others as the tick began if fromFront (pingpong.hpp)
+void acquireTargets( Sector& sector, double time, bool fromFront=false );
+// Due sectors resolving combat shot by shot only
+void acquireTargets( sectors_t& sectors, Schedule const& schedule );
+
+// Fires weapons in contested due sectors over each sector's accrued delta
 void fireWeapons(
-    double delta, //seconds
-    ships_t& ships );
+    Schedule& schedule,
+    sectors_t& sectors );
+
+// Aggregate combat for due sectors below full detail -- O(factions^2) per
+// sector rather than a roll per shot
+void resolveCombat( Schedule& schedule, sectors_t& sectors );
 
+// Respawns ships whose respawn timers fired this tick
 void respawnShips(
-    ships_t& ships,
+    Schedule& schedule,
     Ship* playerShip,
     stations_t& stations,
     bool useJumpgates );
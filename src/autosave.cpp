@@ -0,0 +1,358 @@
+// autosave.cpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#include "autosave.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "constants.hpp"
+#include "opt/saveable.hpp"
+#include "opt/xmlserializer.hpp"
+
+
+namespace tinyspace {
+using std::endl;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+
+namespace {
+
+long minorFaults()
+{
+    struct rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+    return usage.ru_minflt;
+}
+
+double seconds( struct timeval const& t )
+{
+    return t.tv_sec + t.tv_usec / 1e6;
+}
+
+string stallOf( Autosave const& autosave )
+{
+    return autosave.hasStall() ? std::to_string( autosave.stall() * 1000 ) + "ms" : "n/a";
+}
+
+} // anonymous
+
+
+Autosave::Autosave( double interval, string const& path, SnapshotEngine engine )
+    : interval( interval ), path( path ), engine( engine ),
+      saves( 0 ), failures( 0 ), deferred( 0 ), bytes( 0 ), diverged( 0 ), saveTime( 0.0 ), pauseTime( 0.0 ), maxPause( 0.0 ),
+      busyTicks( 0 ), busyTickTime( 0.0 ), maxBusyTick( 0.0 ), busyFaults( 0 ),
+      idleTicks( 0 ), idleTickTime( 0.0 ), idleFaults( 0 ), stallTicks( 0 ), stallTime( 0.0 ), baselineTime( 0.0 ),
+      _thread( nullptr ), _done( false ), _failed( false ), _size( 0 ), _elapsed( 0.0 ),
+      _nextAt( interval ), _children(), _started( 0 ), _committed( 0 ), _faults( 0 ),
+      _recent(), _recentAt( 0 ), _ticks( 0 ), _baseline( -1.0 )
+{}
+
+
+Autosave::~Autosave()
+{
+    if ( _thread )
+    {
+        _thread->join();
+        delete _thread;
+        endSnapshot();
+    }
+    std::ostream nowhere( nullptr );
+    reap( true, nowhere );
+}
+
+
+bool Autosave::isBusy() const
+{
+    return _thread;
+}
+
+
+void Autosave::update(
+    double             time,
+    sectors_t   const& sectors,
+    jumpgates_t const& jumpgates,
+    stations_t  const& stations,
+    ships_t     const& ships,
+    ostream&           log )
+{
+    if ( interval <= 0.0 )
+    {
+        return;
+    }
+    auto start  = steady_clock::now();
+    bool paused = false;
+
+    if ( _thread && _done && ! snapshotReaders )
+    {
+        reconcile( log );
+        paused = true;
+    }
+    if ( ! _children.empty() && reap( false, log ))
+    {
+        paused = true;
+    }
+
+    if ( engine == SnapshotEngine_Fork && time >= _nextAt )
+    {
+        if ( _children.size() < SAVE_MAX_FORKS )
+        {
+            _nextAt = time + interval;
+            markStart();
+            forkSave( time, sectors, jumpgates, stations, ships, log );
+            paused = true;
+        }
+        else
+        {
+            ++deferred;
+        }
+    }
+    else if ( engine == SnapshotEngine_Saveable && ! _thread && time >= _nextAt )
+    {
+        _nextAt = time + interval;
+        _done   = false;
+        markStart();
+        beginSnapshot();
+        _thread = new std::thread( [ this, time, &sectors, &jumpgates, &stations, &ships ]()
+        {
+            auto start = steady_clock::now();
+
+            string xml;
+            {
+                SnapshotReader reader;
+                xml = XmlSerializer( time ).savegame( sectors, jumpgates, stations, ships );
+            }
+
+            // written aside and renamed, so a crash mid-save keeps the previous one
+            string tmpPath = path + ".tmp";
+            std::ofstream file( tmpPath, std::ios::out | std::ios::trunc );
+            file << xml << '\n';
+            file.close();
+
+            _failed  = file.fail() || std::rename( tmpPath.c_str(), path.c_str() ) != 0;
+            _size    = xml.size() + 1;
+            _elapsed = duration<double>( steady_clock::now() - start ).count();
+            _done    = true;
+        });
+        paused = true;
+    }
+
+    if ( paused )
+    {
+        double pause = duration<double>( steady_clock::now() - start ).count();
+        pauseTime += pause;
+        maxPause   = std::max( maxPause, pause );
+    }
+    if ( engine == SnapshotEngine_Fork )
+    {
+        _faults = minorFaults();
+    }
+}
+
+
+void Autosave::finish( ostream& log )
+{
+    if ( _thread )
+    {
+        reconcile( log );
+    }
+    reap( true, log );
+}
+
+
+void Autosave::recordTick( double seconds )
+{
+    if ( interval <= 0.0 )
+    {
+        return;
+    }
+    long faults = engine == SnapshotEngine_Fork ? minorFaults() - _faults : 0;
+    ++_ticks;
+    if ( inFlight() )
+    {
+        ++busyTicks;
+        busyTickTime += seconds;
+        maxBusyTick   = std::max( maxBusyTick, seconds );
+        busyFaults   += faults;
+        if ( _baseline >= 0.0 )
+        {
+            ++stallTicks;
+            stallTime    += seconds - _baseline;
+            baselineTime += _baseline;
+        }
+    }
+    else
+    {
+        ++idleTicks;
+        idleTickTime += seconds;
+        idleFaults   += faults;
+        if ( _ticks <= SAVE_WARMUP_TICKS )
+        {
+            return;
+        }
+        // a rolling window, so the baseline follows the world as it grows
+        if ( _recent.size() < SAVE_IDLE_WINDOW )
+        {
+            _recent.push_back( seconds );
+        }
+        else
+        {
+            _recent[ _recentAt ] = seconds;
+        }
+        _recentAt = ( _recentAt + 1 ) % SAVE_IDLE_WINDOW;
+    }
+}
+
+
+bool Autosave::hasStall() const
+{
+    return stallTicks;
+}
+
+
+double Autosave::stall() const
+{
+    return stallTicks ? stallTime / stallTicks : 0.0;
+}
+
+
+double Autosave::baseline() const
+{
+    return stallTicks ? baselineTime / stallTicks : 0.0;
+}
+
+
+bool Autosave::inFlight() const
+{
+    return _thread || ! _children.empty();
+}
+
+
+void Autosave::markStart()
+{
+    if ( _recent.size() < SAVE_IDLE_MIN )
+    {
+        _baseline = -1.0;
+        return;
+    }
+    double sum = 0.0;
+    for ( double seconds : _recent ) sum += seconds;
+    _baseline = sum / _recent.size();
+}
+
+
+void Autosave::reconcile( ostream& log )
+{
+    _thread->join();
+    delete _thread;
+    _thread  = nullptr;
+    diverged = endSnapshot();
+
+    if ( _failed )
+    {
+        ++failures;
+        log << "save: cannot write " << path << endl;
+        return;
+    }
+    ++saves;
+    bytes     = _size;
+    saveTime += _elapsed;
+    log << "save: " << path << " " << ( bytes / 1024 ) << "KB in " << ( _elapsed * 1000 ) << "ms, "
+        << diverged << " fields diverged"
+        << " (tick stall " << stallOf( *this ) << ", max tick " << ( maxBusyTick * 1000 ) << "ms)" << endl;
+}
+
+
+void Autosave::forkSave(
+    double             time,
+    sectors_t   const& sectors,
+    jumpgates_t const& jumpgates,
+    stations_t  const& stations,
+    ships_t     const& ships,
+    ostream&           log )
+{
+    size_t sequence = ++_started;
+    string tmpPath  = forkPath( sequence );
+    long   faults   = minorFaults();
+
+    pid_t pid = ::fork();
+    if ( pid == 0 )
+    {
+        // the child's image is the world at this tick boundary -- serialize
+        // it, then leave without flushing or destroying anything of the parent's
+        string xml = XmlSerializer( time ).savegame( sectors, jumpgates, stations, ships );
+        std::ofstream file( tmpPath, std::ios::out | std::ios::trunc );
+        file << xml << '\n';
+        file.close();
+        _exit( file.fail() ? 1 : 0 );
+    }
+    if ( pid < 0 )
+    {
+        ++failures;
+        log << "save: cannot fork for " << path << endl;
+        return;
+    }
+    _children.push_back( { pid, sequence, faults } );
+}
+
+
+bool Autosave::reap( bool wait, ostream& log )
+{
+    bool reaped = false;
+    for ( size_t i = 0; i < _children.size(); )
+    {
+        Child const   child = _children[ i ];
+        int           status;
+        struct rusage usage;
+        pid_t pid = wait4( child.pid, &status, wait ? 0 : WNOHANG, &usage );
+        if ( pid == 0 )
+        {
+            ++i; // still serializing
+            continue;
+        }
+        _children.erase( _children.begin() + i );
+        reaped = true;
+
+        string tmpPath = forkPath( child.sequence );
+        if ( child.sequence < _committed )
+        {
+            std::remove( tmpPath.c_str() ); // a later save is already in place
+            continue;
+        }
+        struct stat file;
+        if ( pid != child.pid || ! WIFEXITED( status ) || WEXITSTATUS( status ) != 0
+          || stat( tmpPath.c_str(), &file ) != 0 || std::rename( tmpPath.c_str(), path.c_str() ) != 0 )
+        {
+            ++failures;
+            std::remove( tmpPath.c_str() );
+            log << "save: cannot write " << path << endl;
+            continue;
+        }
+        double cpu = seconds( usage.ru_utime ) + seconds( usage.ru_stime );
+        _committed = child.sequence;
+        ++saves;
+        bytes     = file.st_size;
+        saveTime += cpu;
+        log << "save: " << path << " " << ( bytes / 1024 ) << "KB in " << ( cpu * 1000 ) << "ms (child cpu), "
+            << ( minorFaults() - child.faults ) << " page faults meanwhile"
+            << " (tick stall " << stallOf( *this ) << ", max tick " << ( maxBusyTick * 1000 ) << "ms)" << endl;
+    }
+    return reaped;
+}
+
+
+string Autosave::forkPath( size_t sequence ) const
+{
+    return path + "." + std::to_string( getpid() ) + "." + std::to_string( sequence ) + ".tmp";
+}
+
+
+} // tinyspace
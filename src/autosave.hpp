@@ -0,0 +1,173 @@
+// autosave.hpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#ifndef _TINYSPACE_AUTOSAVE_HPP_
+#define _TINYSPACE_AUTOSAVE_HPP_
+
+
+#include <atomic>
+#include <ostream>
+#include <thread>
+#include <sys/types.h>
+#include "models.hpp"
+#include "types.hpp"
+
+
+namespace tinyspace {
+using std::ostream;
+
+
+// Where a save's consistent image of the world comes from
+enum SnapshotEngine : unsigned int
+{
+    SnapshotEngine_Saveable, // a save thread reads the fields' set-aside values (opt/saveable.hpp)
+    SnapshotEngine_Fork,     // a forked child serializes its copy-on-write image of the process
+    SnapshotEngine_END
+};
+
+
+inline string snapshotEngineName( SnapshotEngine engine )
+{
+    switch ( engine )
+    {
+        case SnapshotEngine_Saveable: return "saveable";
+        case SnapshotEngine_Fork:     return "fork";
+        default:                      return "";
+    }
+}
+
+
+// The engine called name -- SnapshotEngine_END if none is
+inline SnapshotEngine snapshotEngineNamed( string const& name )
+{
+    for ( unsigned int engine = 0; engine < SnapshotEngine_END; ++engine )
+    {
+        if ( snapshotEngineName( static_cast<SnapshotEngine>( engine )) == name )
+        {
+            return static_cast<SnapshotEngine>( engine );
+        }
+    }
+    return SnapshotEngine_END;
+}
+
+
+// Background savegame.
+//
+// Saveable engine -- the ship, weapon and sector fields a save reads are
+// Saveable (opt/saveable.hpp): while a save is in flight, the first write to
+// each one sets the value it held aside, so the save thread -- a
+// SnapshotReader -- serializes the world as it stood when the save began
+// while ticks keep running. The first tick boundary after one finishes with
+// no other readers on the snapshot joins the save thread and reconciles the
+// set-aside values (endSnapshot) -- until then ship records must stay put,
+// so storage reorders wait (isBusy).
+//
+// Fork engine -- the process forks and the child serializes its own
+// copy-on-write image of the world, then exits. Fields pay nothing; the
+// parent pays for the fork, and a page fault for each page it first writes
+// while a child shares it. Children are reaped without blocking at tick
+// boundaries, at most SAVE_MAX_FORKS at a time. Each writes aside and the
+// parent renames in start order, so a slow child never replaces a later save.
+//
+// Either way, saves start at a tick boundary once their interval of sim time
+// has passed. Double buffered (pingpong.hpp), the fields' two slots carry
+// each tick's front buffer and can't also hold a save's image for the ticks
+// it spans -- saves there fork.
+struct Autosave
+{
+    double         interval; // sim time (seconds) between saves
+    string         path;
+    SnapshotEngine engine;
+
+    size_t saves;         // completed
+    size_t failures;      // saves that could not be written
+    size_t deferred;      // tick boundaries a due save waited at the fork cap
+    size_t bytes;         // size of the latest save
+    size_t diverged;      // fields written during the latest save, reconciled after it
+    double saveTime;      // seconds the save thread (wall) or child (cpu) spent, over all saves
+    double pauseTime;     // wall seconds ticks waited starting and reconciling saves (forking them)
+    double maxPause;      // ...the longest single wait
+    size_t busyTicks;     // ticks run while a save was in flight
+    double busyTickTime;  // ...their wall seconds
+    double maxBusyTick;   // ...the longest of them
+    long   busyFaults;    // ...the minor page faults they took (copy-on-write, under a fork)
+    size_t idleTicks;     // ticks run with no save in flight
+    double idleTickTime;  // ...their wall seconds
+    long   idleFaults;    // ...the minor page faults they took
+    size_t stallTicks;    // busy ticks measured against the warm idle ticks before their save started
+    double stallTime;     // ...wall seconds they took over that baseline
+    double baselineTime;  // ...the baselines, summed
+
+    Autosave( double interval, string const& path, SnapshotEngine engine=SnapshotEngine_Saveable );
+    ~Autosave(); // waits for saves in flight
+
+    // Whether a save reads records in place -- they mustn't move
+    bool isBusy() const;
+
+    // At a tick boundary -- reconciles finished saves, then starts the next
+    // one if it's due
+    void update(
+        double             time,
+        sectors_t   const& sectors,
+        jumpgates_t const& jumpgates,
+        stations_t  const& stations,
+        ships_t     const& ships,
+        ostream&           log );
+
+    // Waits for saves in flight and reconciles them
+    void finish( ostream& log );
+
+    // Files a tick's wall seconds and page faults under whether a save was
+    // in flight
+    void recordTick( double seconds );
+
+    // Whether any tick in flight had a baseline to measure a stall against
+    bool hasStall() const;
+    // Mean extra wall seconds a tick took while a save was in flight
+    double stall() const;
+    // Mean wall seconds of the idle ticks stalls are measured against
+    double baseline() const;
+
+private:
+    struct Child
+    {
+        pid_t  pid;
+        size_t sequence; // start order
+        long   faults;   // parent minor faults when forked
+    };
+
+    std::thread*      _thread;
+    std::atomic<bool> _done;
+    bool              _failed;    // written by the save thread before _done
+    size_t            _size;      // ...
+    double            _elapsed;   // ...
+    double            _nextAt;    // sim time the next save is due
+    vector<Child>     _children;  // forked saves in flight, in start order
+    size_t            _started;   // forked saves begun
+    size_t            _committed; // sequence of the newest forked save renamed into place
+    long              _faults;    // minor faults as the tick began
+    vector<double>    _recent;    // wall seconds of the latest warm idle ticks, a ring
+    size_t            _recentAt;  // slot the next one goes in
+    size_t            _ticks;     // recorded
+    double            _baseline;  // mean of _recent as the latest save started -- negative if too few
+
+    bool inFlight() const;
+    void markStart(); // takes the baseline
+    void reconcile( ostream& log );
+    void forkSave(
+        double             time,
+        sectors_t   const& sectors,
+        jumpgates_t const& jumpgates,
+        stations_t  const& stations,
+        ships_t     const& ships,
+        ostream&           log );
+    bool reap( bool wait, ostream& log ); // true if any child was reaped
+    string forkPath( size_t sequence ) const;
+};
+
+
+} // tinyspace
+
+
+#endif // _TINYSPACE_AUTOSAVE_HPP_
@@ -0,0 +1,128 @@
+// budget.cpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#include "budget.hpp"
+
+#include "constants.hpp"
+
+
+namespace tinyspace {
+
+
+TickBudget::TickBudget( double budget )
+    : budget( budget ), level( BudgetLevel_Nominal ), phases(),
+      _tick( 0 ), _wait( 0 ), _calm( 0 ), _displayCost( 0.0 )
+{}
+
+
+TickBudget::~TickBudget()
+{}
+
+
+bool TickBudget::isDisplayDue() const
+{
+    return level < BudgetLevel_Display || _tick % BUDGET_DISPLAY_INTERVAL == 0;
+}
+
+
+double TickBudget::load() const
+{
+    double total = 0.0;
+    for ( auto phase : phases ) total += phase;
+    return total;
+}
+
+
+void TickBudget::apply( LevelOfDetail& lod, Schedule& schedule ) const
+{
+    lod.reducedDistance   = level >= BudgetLevel_Detail ? lod.fullDistance : LOD_REDUCED_DISTANCE;
+    schedule.coarseCombat = level >= BudgetLevel_Combat;
+}
+
+
+void TickBudget::setLevel( BudgetLevel level, LevelOfDetail& lod, Schedule& schedule )
+{
+    if ( level != this->level )
+    {
+        this->level = level;
+        apply( lod, schedule );
+    }
+}
+
+
+bool TickBudget::update(
+    double const (&times)[ TickPhase_END ],
+    LevelOfDetail& lod,
+    Schedule& schedule,
+    ostream& log )
+{
+    // skipped frames cost nothing -- the display phase is the redraw cost
+    // spread over the frames it covers
+    if ( isDisplayDue() )
+    {
+        _displayCost += ( times[ TickPhase_Display ] - _displayCost ) * BUDGET_SMOOTHING;
+    }
+    for ( size_t phase = 0; phase < TickPhase_END; ++phase )
+    {
+        if ( phase == TickPhase_Display )
+        {
+            phases[ phase ] = level >= BudgetLevel_Display ? _displayCost / BUDGET_DISPLAY_INTERVAL : _displayCost;
+        }
+        else
+        {
+            phases[ phase ] += ( times[ phase ] - phases[ phase ] ) * BUDGET_SMOOTHING;
+        }
+    }
+    ++_tick;
+
+    double cost = load();
+    BudgetLevel previous = level;
+
+    if ( _wait )
+    {
+        --_wait;
+    }
+    if ( cost > budget )
+    {
+        _calm = 0;
+        if ( ! _wait && level + 1 < BudgetLevel_END )
+        {
+            size_t heaviest = 0;
+            for ( size_t phase = 1; phase < TickPhase_END; ++phase )
+            {
+                if ( phases[ phase ] > phases[ heaviest ] ) heaviest = phase;
+            }
+            level = static_cast<BudgetLevel>( level + 1 );
+            _wait = BUDGET_SHED_DELAY;
+            log << "budget: " << ( cost * 1000 ) << "ms over " << ( budget * 1000 ) << "ms"
+                << " (" << tickPhaseName( static_cast<TickPhase>( heaviest )) << " " << ( phases[ heaviest ] * 1000 ) << "ms)"
+                << " -- shedding " << budgetLevelName( level ) << std::endl;
+        }
+    }
+    else if ( level > BudgetLevel_Nominal && cost < budget * BUDGET_RESTORE_SHARE )
+    {
+        if ( ++_calm >= BUDGET_RESTORE_DELAY )
+        {
+            log << "budget: " << ( cost * 1000 ) << "ms under " << ( budget * BUDGET_RESTORE_SHARE * 1000 ) << "ms"
+                << " for " << _calm << " ticks -- restoring " << budgetLevelName( level ) << std::endl;
+            level = static_cast<BudgetLevel>( level - 1 );
+            _calm = 0;
+            _wait = BUDGET_SHED_DELAY;
+        }
+    }
+    else
+    {
+        _calm = 0;
+    }
+
+    if ( level != previous )
+    {
+        apply( lod, schedule );
+        return true;
+    }
+    return false;
+}
+
+
+} // tinyspace
@@ -0,0 +1,120 @@
+// budget.hpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#ifndef _TINYSPACE_BUDGET_HPP_
+#define _TINYSPACE_BUDGET_HPP_
+
+
+#include <ostream>
+#include <string>
+#include "lod.hpp"
+#include "schedule.hpp"
+
+
+namespace tinyspace {
+
+
+using std::ostream;
+using std::string;
+
+
+enum TickPhase : unsigned int
+{
+    TickPhase_Detail,   // level of detail, traffic and respawns
+    TickPhase_Movement,
+    TickPhase_Combat,   // targeting, weapons fire and aggregate combat
+    TickPhase_Locality, // ship storage reorders
+    TickPhase_Publish,  // tick records for a replica (replica.hpp)
+    TickPhase_Display,
+    TickPhase_END
+};
+
+
+// Fidelity shed to stay within the tick budget, in the order it's given up
+enum BudgetLevel : unsigned int
+{
+    BudgetLevel_Nominal,
+    BudgetLevel_Display, // redraw every BUDGET_DISPLAY_INTERVAL ticks
+    BudgetLevel_Detail,  // sectors past LOD_FULL_DISTANCE go dormant
+    BudgetLevel_Combat,  // only watched sectors resolve combat shot by shot
+    BudgetLevel_END
+};
+
+
+inline string tickPhaseName( TickPhase phase )
+{
+    switch ( phase )
+    {
+        case TickPhase_Detail:   return "detail";
+        case TickPhase_Movement: return "movement";
+        case TickPhase_Combat:   return "combat";
+        case TickPhase_Locality: return "locality";
+        case TickPhase_Publish:  return "publish";
+        case TickPhase_Display:  return "display";
+        default:                 return "";
+    }
+}
+
+
+inline string budgetLevelName( BudgetLevel level )
+{
+    switch ( level )
+    {
+        case BudgetLevel_Nominal: return "nominal";
+        case BudgetLevel_Display: return "display rate";
+        case BudgetLevel_Detail:  return "far sector detail";
+        case BudgetLevel_Combat:  return "combat resolution";
+        default:                  return "";
+    }
+}
+
+
+// Tick budget controller.
+//
+// Phase times are smoothed across ticks and their sum held against the
+// budget. Over budget, one more level is shed, then the controller waits
+// BUDGET_SHED_DELAY ticks for it to take effect before shedding again. A
+// level is restored only after BUDGET_RESTORE_DELAY ticks under
+// BUDGET_RESTORE_SHARE of the budget, so a restore that would put the tick
+// straight back over doesn't oscillate. Every change is logged with its cause.
+struct TickBudget
+{
+    double      budget;                 // seconds per tick
+    BudgetLevel level;
+    double      phases[ TickPhase_END ]; // smoothed seconds per tick (display amortized over skipped frames)
+
+    TickBudget( double budget );
+    ~TickBudget();
+
+    // Whether this tick redraws the display
+    bool isDisplayDue() const;
+
+    // Records the tick's phase times and sheds or restores a level as needed.
+    // Returns true if the level changed.
+    bool update(
+        double const (&times)[ TickPhase_END ], // seconds
+        LevelOfDetail& lod,
+        Schedule& schedule,
+        ostream& log );
+
+    // Smoothed seconds per tick over all phases
+    double load() const;
+
+    // Sheds exactly the given level, bypassing the controller (replays)
+    void setLevel( BudgetLevel level, LevelOfDetail& lod, Schedule& schedule );
+
+private:
+    size_t _tick;
+    size_t _wait;        // ticks before another level may be shed
+    size_t _calm;        // consecutive ticks with headroom
+    double _displayCost; // smoothed seconds per redraw
+
+    void apply( LevelOfDetail& lod, Schedule& schedule ) const;
+};
+
+
+} // tinyspace
+
+
+#endif // _TINYSPACE_BUDGET_HPP_
@@ -30,9 +30,33 @@ float        const PLAYER_FREQUENCY        = 0.01f;
 float        const FRIEND_FREQUENCY        = 0.2f;
 float        const ENEMY_FREQUENCY         = 0.1f;
 float        const MISC_DESTINATION_CHANCE = 0.1f;
+float        const JOURNEY_CHANCE          = 0.5f; // undocking ships setting out for a distant sector
 size_t       const TICK_TIME               = 300;  // milliseconds
+double       const MAX_TICK_DELTA          = 1.0;  // seconds -- a stalled tick is simulated no further than this
 float        const DOCK_TIME               = 3.f;  // seconds
 float        const RESPAWN_TIME            = 10.f; // seconds
+float        const RESPAWN_RETRY_TIME      = 1.f;  // seconds -- respawn held back while the player watches
+double       const TIMER_RESOLUTION        = 0.05; // seconds per timing wheel slot
+unsigned int const LOD_FULL_DISTANCE       = 1;    // sector hops from a watched sector
+unsigned int const LOD_REDUCED_DISTANCE    = 3;    // sector hops from a watched sector
+size_t       const LOD_REDUCED_INTERVAL    = 4;    // ticks
+unsigned int const LOD_DEMOTE_DELAY        = 10;   // ticks a sector keeps its tier after falling out of range
+size_t       const TRAFFIC_INTERVAL        = 16;   // ticks between a dormant sector's flow steps
+float        const TRAFFIC_LEG_LENGTH      = 0.52f; // mean leg as a share of sector size (uniform points in a square)
+float        const AGGREGATE_ENGAGEMENT    = 0.07f; // share of firepower landing in aggregate combat -- stands in for weapon range too (bench/engagement)
+float        const BUDGET_SMOOTHING        = 0.25f; // weight of the latest tick in smoothed phase times
+float        const BUDGET_RESTORE_SHARE    = 0.5f; // share of the tick budget to stay under before restoring fidelity
+size_t       const BUDGET_SHED_DELAY       = 5;    // ticks for a shed level to take effect before shedding another
+size_t       const BUDGET_RESTORE_DELAY    = 30;   // ticks with headroom before restoring a level
+size_t       const BUDGET_DISPLAY_INTERVAL = 4;    // ticks per redraw while the display rate is shed
+size_t       const SAVE_MAX_FORKS          = 2;    // forked snapshots in flight at once -- a due save waits at the cap
+size_t       const SAVE_WARMUP_TICKS       = 20;   // ticks before idle ones count toward a save's stall baseline -- caches are cold
+size_t       const SAVE_IDLE_WINDOW        = 32;   // latest idle ticks a save's stall is measured against
+size_t       const SAVE_IDLE_MIN           = 8;    // ...fewer, and the ticks it spans aren't measured
+size_t       const REPLICA_RING_BYTES      = 8 << 20; // shared-memory ring carrying a primary's ticks to its replica
+size_t       const REPLICA_CHECK_TICKS     = 100;     // ticks between the state hashes a primary publishes
+double       const REPLICA_ATTACH_TIMEOUT  = 10.0;    // seconds a replica waits for its primary's stream to appear
+double       const REPLICA_POLL_TIME       = 0.001;   // seconds a replica sleeps on an empty ring
 
 Vector2<position_t> const
     GATE_RANGE_NORTH {{ SECTOR_SIZE.x/3.f + 0.1f, 0.25f },               { 2*SECTOR_SIZE.x/3.f - 0.1f, SECTOR_SIZE.y/5.f }},
@@ -40,7 +64,7 @@ Vector2<position_t> const
     GATE_RANGE_SOUTH {{ SECTOR_SIZE.x/3.f + 0.1f, 4*SECTOR_SIZE.y/5.f }, { 2*SECTOR_SIZE.x/3.f - 0.1f, SECTOR_SIZE.y - 0.25f }},
     GATE_RANGE_WEST  {{ 0.25f, SECTOR_SIZE.y/3.f + 0.1f },               { SECTOR_SIZE.x/5.f, 2*SECTOR_SIZE.y/3.f - 0.1f }};
 
-speed_t const DISTANCE_MULTIPLIER = 0.002f;
+constexpr speed_t DISTANCE_MULTIPLIER = 0.002f;
 
 speed_t const
     COURIER_SPEED   = 600 * DISTANCE_MULTIPLIER,
@@ -56,12 +80,13 @@ unsigned int const
     CORVETTE_HULL  = 1200,
     FRIGATE_HULL   = 1800;
 
-distance_t const
+constexpr distance_t
     PULSE_RANGE    = 1000 * DISTANCE_MULTIPLIER,
     CANNON_RANGE   = 2000 * DISTANCE_MULTIPLIER,
     BEAM_RANGE     =  750 * DISTANCE_MULTIPLIER;
 
-distance_t const MAX_TO_HIT_RANGE = 2000 * DISTANCE_MULTIPLIER; // match longest range weapon
+constexpr distance_t MAX_TO_HIT_RANGE         = 2000 * DISTANCE_MULTIPLIER; // match longest range weapon
+constexpr distance_t MAX_TO_HIT_RANGE_SQUARED = MAX_TO_HIT_RANGE * MAX_TO_HIT_RANGE;
 
 // Cooldown in seconds
 float const
@@ -74,22 +99,111 @@ unsigned int const
     CANNON_DAMAGE  = 60, // per shot
     BEAM_DAMAGE    = 20; // per second
 
-float const
+constexpr float
     PULSE_ACCURACY  = 0.8f,
     CANNON_ACCURACY = 0.5f,
     BEAM_ACCURACY   = 0.95f;
 
-float const  // for targets
+constexpr float  // for targets
     COURIER_ACCURACY_MULTIPLIER   = 0.75f,
     TRANSPORT_ACCURACY_MULTIPLIER = 1.f,
     SCOUT_ACCURACY_MULTIPLIER     = 0.6f,
     CORVETTE_ACCURACY_MULTIPLIER  = 1.2f,
     FRIGATE_ACCURACY_MULTIPLIER   = 1.8f;
 
-float const TURRET_RANGE_SCALE = 0.5;
+constexpr float TURRET_RANGE_SCALE = 0.5;
 float const TURRET_DAMAGE_SCALE = 0.7;
 
 
+constexpr unsigned int factionBit( ShipFaction faction )
+{
+    return 1u << faction;
+}
+
+// Faction hostility -- row is the attacking faction, each set bit a faction it
+// will engage. Neutral ships are not part of the combat system.
+static_assert( ShipFaction_END == 4, "FACTION_HOSTILITY needs a row per faction" );
+constexpr unsigned int FACTION_HOSTILITY[ ShipFaction_END ] = {
+    /* Neutral */ 0,
+    /* Player  */ factionBit( ShipFaction_Foe ),
+    /* Friend  */ factionBit( ShipFaction_Foe ),
+    /* Foe     */ factionBit( ShipFaction_Player ) | factionBit( ShipFaction_Friend ),
+};
+
+
+// ---------------------------------------------------------------------------
+// Lookup Tables
+// ---------------------------------------------------------------------------
+
+
+constexpr distance_t weaponRange( WeaponType weaponType, bool isTurret )
+{
+    return ( weaponType == WeaponType_Pulse  ? PULSE_RANGE
+           : weaponType == WeaponType_Cannon ? CANNON_RANGE
+           : weaponType == WeaponType_Beam   ? BEAM_RANGE
+           :                                   0.f ) * ( isTurret ? TURRET_RANGE_SCALE : 1.f );
+}
+
+
+constexpr float weaponAccuracy( WeaponType weaponType, TargetType targetType )
+{
+    return ( weaponType == WeaponType_Pulse  ? PULSE_ACCURACY
+           : weaponType == WeaponType_Cannon ? CANNON_ACCURACY
+           : weaponType == WeaponType_Beam   ? BEAM_ACCURACY
+           :                                   0.f )
+         * ( targetType == TargetType_Courier   ? COURIER_ACCURACY_MULTIPLIER
+           : targetType == TargetType_Transport ? TRANSPORT_ACCURACY_MULTIPLIER
+           : targetType == TargetType_Scout     ? SCOUT_ACCURACY_MULTIPLIER
+           : targetType == TargetType_Corvette  ? CORVETTE_ACCURACY_MULTIPLIER
+           : targetType == TargetType_Frigate   ? FRIGATE_ACCURACY_MULTIPLIER
+           :                                      1.f );
+}
+
+
+struct HitChance
+{
+    float      accuracy;     // chance to hit when in range
+    distance_t rangeSquared;
+};
+
+
+struct HitChanceRow
+{
+    HitChance byTarget[ TargetType_END ];
+
+    constexpr HitChance const& operator []( size_t targetType ) const { return byTarget[ targetType ]; }
+};
+
+
+constexpr HitChance hitChance( WeaponType weaponType, bool isTurret, TargetType targetType )
+{
+    return HitChance{ weaponAccuracy( weaponType, targetType ),
+                      weaponRange( weaponType, isTurret ) * weaponRange( weaponType, isTurret ) };
+}
+
+
+static_assert( TargetType_END == 6, "hitChanceRow needs an entry per target type" );
+constexpr HitChanceRow hitChanceRow( WeaponType weaponType, bool isTurret )
+{
+    return HitChanceRow{{ hitChance( weaponType, isTurret, TargetType_NONE ),
+                          hitChance( weaponType, isTurret, TargetType_Courier ),
+                          hitChance( weaponType, isTurret, TargetType_Transport ),
+                          hitChance( weaponType, isTurret, TargetType_Scout ),
+                          hitChance( weaponType, isTurret, TargetType_Corvette ),
+                          hitChance( weaponType, isTurret, TargetType_Frigate ) }};
+}
+
+
+// Indexed by [ WeaponType ][ isTurret ][ TargetType ]
+static_assert( WeaponType_END == 4, "HIT_CHANCE needs a row per weapon type" );
+constexpr HitChanceRow HIT_CHANCE[ WeaponType_END ][ 2 ] = {
+    { hitChanceRow( WeaponType_NONE,   false ), hitChanceRow( WeaponType_NONE,   true ) },
+    { hitChanceRow( WeaponType_Pulse,  false ), hitChanceRow( WeaponType_Pulse,  true ) },
+    { hitChanceRow( WeaponType_Cannon, false ), hitChanceRow( WeaponType_Cannon, true ) },
+    { hitChanceRow( WeaponType_Beam,   false ), hitChanceRow( WeaponType_Beam,   true ) },
+};
+
+
 // ---------------------------------------------------------------------------
 // Dynamic Constants
 // ---------------------------------------------------------------------------
@@ -232,6 +346,12 @@ inline float weaponCooldown( WeaponType weaponType )
     }
 }
 
+inline bool isHostile( ShipFaction faction, ShipFaction otherFaction )
+{
+    return FACTION_HOSTILITY[ faction ] & factionBit( otherFaction );
+}
+
+
 inline float isWeaponDamageOverTime( WeaponType weaponType )
 {
     switch ( weaponType )
@@ -187,7 +187,7 @@ jumpgates_t initJumpgates( sectors_t& sectors, bool useJumpgates )
             auto& neighbors    = sector.neighbors;
             auto& jumpgates    = sector.jumpgates;
 
-            int jumpgatesCount = 1 + ( rand() % sector.neighbors.count() ) - sector.jumpgates.count();
+            int jumpgatesCount = 1 + ( randInt() % sector.neighbors.count() ) - sector.jumpgates.count();
 
             // Populate jumpgates in an XY-forward direction
             while ( jumpgatesCount > 0 &&
@@ -198,7 +198,7 @@ jumpgates_t initJumpgates( sectors_t& sectors, bool useJumpgates )
                 if ( jumpgatesCount > 0 &&
                      neighbors.south &&
                      ! jumpgates.south &&
-                     rand() % 2 &&
+                     randInt() % 2 &&
                      addJumpgateSouth( sector ))
                 {
                     --jumpgatesCount;
@@ -208,7 +208,7 @@ jumpgates_t initJumpgates( sectors_t& sectors, bool useJumpgates )
                 if ( jumpgatesCount > 0 &&
                      neighbors.west &&
                      ! jumpgates.west &&
-                     rand() % 2 &&
+                     randInt() % 2 &&
                      addJumpgateWest( sector ))
                 {
                     --jumpgatesCount;
@@ -355,6 +355,36 @@ stations_t initStations( sectors_t& sectors )
 }
 
 
+void armShip( Ship& ship )
+{
+    auto weapons = shipWeapons( ship.type );
+    auto turrets = shipTurrets( ship.type );
+
+    weapon_ptrs_t newWeapons;
+    weapon_ptrs_t newTurrets;
+    newWeapons.reserve( weapons.size() );
+    newTurrets.reserve( turrets.size() );
+    bool isSideFire = isShipSideFire( ship.type );
+    for ( size_t i = 0; i < ( isSideFire ? 2 : 1 ); ++i )
+    {
+        for ( WeaponType weapon : weapons )
+        {
+            WeaponPosition weaponPosition = isSideFire
+                                          ? i ? WeaponPosition_Port
+                                              : WeaponPosition_Starboard
+                                          : WeaponPosition_Bow;
+            newWeapons.emplace( newWeapons.end(), weapon_ptr_t( new Weapon( weapon, false, weaponPosition, ship )));
+        }
+    }
+    for ( WeaponType turret : turrets )
+    {
+        newTurrets.emplace( newTurrets.end(), weapon_ptr_t( new Weapon( turret, true, WeaponPosition_Bow, ship )));
+    }
+    ship.setWeapons( std::move( newWeapons ));
+    ship.setTurrets( std::move( newTurrets ));
+}
+
+
 ships_t initShips(
     size_t const& shipCount,
     sectors_t& sectors,
@@ -368,7 +398,7 @@ ships_t initShips(
     for ( size_t i = 0; i < shipCount; ++i )
     {
         bool isPlayerShip = i == 0;
-        auto& sector = sectors[ rand() % sectors.size() ][ rand() % sectors[ 0 ].size() ];
+        auto& sector = sectors[ randInt() % sectors.size() ][ randInt() % sectors[ 0 ].size() ];
         auto type    = randShipType();
         auto hull    = shipHull( type );
         auto code    = randCode();
@@ -377,34 +407,10 @@ ships_t initShips(
         auto dest    = randDestination( sector, useJumpgates, ( isPlayerShip ? 0.f : MISC_DESTINATION_CHANCE ));
         auto dir     = dest ? ( dest->position - pos ).normalized() : randDirection();
         auto speed   = shipSpeed( type );
-        auto weapons = shipWeapons( type );
-        auto turrets = shipTurrets( type );
         auto it      = ships.emplace( ships.end(), type, hull, code, name, &sector, pos, dir, speed, dest );
         auto& ship   = *it;
 
-        // weapons/turrets
-        weapon_ptrs_t newWeapons;
-        weapon_ptrs_t newTurrets;
-        newWeapons.reserve( weapons.size() );
-        newTurrets.reserve( turrets.size() );
-        bool isSideFire = isShipSideFire( type );
-        for ( size_t i = 0; i < ( isSideFire ? 2 : 1 ); ++i )
-        {
-            for ( WeaponType weapon : weapons )
-            {
-                WeaponPosition weaponPosition = isSideFire
-                                              ? i ? WeaponPosition_Port
-                                                  : WeaponPosition_Starboard
-                                              : WeaponPosition_Bow;
-                newWeapons.emplace( newWeapons.end(), weapon_ptr_t( new Weapon( weapon, false, weaponPosition, ship )));
-            }
-        }
-        for ( WeaponType turret : turrets )
-        {
-            newTurrets.emplace( newTurrets.end(), weapon_ptr_t( new Weapon( turret, true, WeaponPosition_Bow, ship )));
-        }
-        ship.setWeapons( std::move( newWeapons ));
-        ship.setTurrets( std::move( newTurrets ));
+        armShip( ship );
 
         // friend/foe
         if ( isPlayerShip )
@@ -15,6 +15,9 @@ namespace tinyspace {
 sectors_t initSectors( v2size_t const& bounds, dimensions_t const& size );
 jumpgates_t initJumpgates( sectors_t& sectors, bool useJumpgates );
 stations_t initStations( sectors_t& sectors );
+// Fits a ship with its type's weapons and turrets
+void armShip( Ship& ship );
+
 ships_t initShips(
     size_t const& shipCount,
     sectors_t& sectors,
@@ -0,0 +1,182 @@
+// locality.cpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#include "locality.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+
+
+namespace tinyspace {
+
+
+namespace {
+
+uintptr_t const PAGE_SIZE = 4096;
+
+// Spreads the low 16 bits of x to the even bits
+inline uint32_t spreadBits( uint32_t x )
+{
+    x &= 0xFFFF;
+    x = ( x | ( x << 8 )) & 0x00FF00FF;
+    x = ( x | ( x << 4 )) & 0x0F0F0F0F;
+    x = ( x | ( x << 2 )) & 0x33333333;
+    x = ( x | ( x << 1 )) & 0x55555555;
+    return x;
+}
+
+// Z-order of a position within its sector -- nearby positions get nearby codes
+inline uint32_t mortonCode( Ship const& ship )
+{
+    auto quantize = []( float value, float size ) -> uint32_t
+    {
+        float share = size > 0.f ? value / size : 0.f;
+        return static_cast<uint32_t>( std::min( std::max( share, 0.f ), 1.f ) * 0xFFFF );
+    };
+    return spreadBits( quantize( ship.position.x, ship.sector->size.x ))
+         | spreadBits( quantize( ship.position.y, ship.sector->size.y )) << 1;
+}
+
+} // anonymous
+
+
+ShipLocality::ShipLocality( size_t shipCount )
+    : reorders( 0 ), pagesBefore( 0 ), pagesAfter( 0 ),
+      _indices( shipCount ), _handles( shipCount )
+{
+    for ( size_t i = 0; i < shipCount; ++i )
+    {
+        _indices[ i ] = i;
+        _handles[ i ] = i;
+    }
+}
+
+
+ShipLocality::~ShipLocality()
+{}
+
+
+Ship& ShipLocality::resolve( ships_t& ships, ShipHandle handle ) const
+{
+    return ships[ _indices[ handle.slot ]];
+}
+
+
+Ship const& ShipLocality::resolve( ships_t const& ships, ShipHandle handle ) const
+{
+    return ships[ _indices[ handle.slot ]];
+}
+
+
+ShipHandle ShipLocality::handleOf( ships_t const& ships, Ship const* ship ) const
+{
+    return { _handles[ ship - ships.data() ] };
+}
+
+
+size_t ShipLocality::sweepPages( sectors_t const& sectors )
+{
+    size_t pages = 0;
+    std::set<uintptr_t> touched;
+    for ( auto& sectorRow : sectors )
+    {
+        for ( auto& sector : sectorRow )
+        {
+            touched.clear();
+            for ( ShipState state : { ShipState_Flying, ShipState_Docked } )
+            {
+                for ( size_t faction = 0; faction < ShipFaction_END; ++faction )
+                {
+                    for ( Ship* ship : sector.stateShips( state, static_cast<ShipFaction>( faction )))
+                    {
+                        touched.insert( reinterpret_cast<uintptr_t>( ship ) / PAGE_SIZE );
+                    }
+                }
+            }
+            pages += touched.size();
+        }
+    }
+    return pages;
+}
+
+
+void ShipLocality::reorder( ships_t& ships, sectors_t& sectors, Schedule& schedule, Traffic& traffic )
+{
+    size_t const shipCount = ships.size();
+    size_t const colCount  = sectors.empty() ? 0 : sectors[ 0 ].size();
+
+    pagesBefore = sweepPages( sectors );
+
+    // sort key -- sector in the high half (parked ships last), Morton code in the low
+    vector<pair<uint64_t, size_t>> keys;
+    keys.reserve( shipCount );
+    for ( size_t i = 0; i < shipCount; ++i )
+    {
+        Ship const& ship = ships[ i ];
+        uint64_t key = ship.sector
+                     ? static_cast<uint64_t>( ship.sector->rowcol.first * colCount + ship.sector->rowcol.second ) << 32
+                       | mortonCode( ship )
+                     : UINT64_MAX;
+        keys.push_back( { key, i } );
+    }
+    std::sort( keys.begin(), keys.end() );
+
+    ships_t reordered;
+    reordered.reserve( shipCount );
+    vector<Ship*>  relocated( shipCount ); // new record by old index
+    vector<size_t> handles( shipCount );
+    for ( size_t i = 0; i < shipCount; ++i )
+    {
+        size_t from = keys[ i ].second;
+        reordered.push_back( std::move( ships[ from ] ));
+        relocated[ from ]   = &reordered.back();
+        handles[ i ]        = _handles[ from ];
+        _indices[ handles[ i ]] = i;
+    }
+    _handles.swap( handles );
+
+    // old records are still in place, so old pointers resolve by index
+    Ship* const base = ships.data();
+    auto relocate = [ & ]( Ship* ship ) -> Ship*
+    {
+        return ship ? relocated[ ship - base ] : nullptr;
+    };
+    auto relocateTarget = [ & ]( target_ptr_t target ) -> target_ptr_t
+    {
+        return target ? relocate( static_cast<Ship*>( target )) : nullptr;
+    };
+
+    for ( auto& ship : reordered )
+    {
+        ship.target = relocateTarget( ship.target );
+        for ( auto& weapon : ship.weapons() )
+        {
+            weapon->parent = &ship;
+            weapon->target = relocateTarget( weapon->target );
+        }
+        for ( auto& turret : ship.turrets() )
+        {
+            turret->parent = &ship;
+            turret->target = relocateTarget( turret->target );
+        }
+    }
+    for ( auto& sectorRow : sectors )
+    {
+        for ( auto& sector : sectorRow )
+        {
+            sector.relocateShips( relocate );
+        }
+    }
+    schedule.relocateShips( relocate );
+    traffic.relocateShips( relocate );
+
+    ships.swap( reordered );
+
+    ++reorders;
+    pagesAfter = sweepPages( sectors );
+}
+
+
+} // tinyspace
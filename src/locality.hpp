@@ -0,0 +1,64 @@
+// locality.hpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#ifndef _TINYSPACE_LOCALITY_HPP_
+#define _TINYSPACE_LOCALITY_HPP_
+
+
+#include "models.hpp"
+#include "schedule.hpp"
+#include "traffic.hpp"
+#include "types.hpp"
+
+
+namespace tinyspace {
+
+
+// Stable reference to a ship record. Ship storage is reordered for locality,
+// so pointers and indices into ships_t only hold until the next reorder --
+// anything kept across ticks outside the simulation holds a handle instead.
+struct ShipHandle
+{
+    size_t slot;
+};
+
+
+// Ship storage locality.
+//
+// Sectors reach their ships through pointers into ships_t, which stays in
+// spawn order while ships migrate, so sweeping a sector jumps all over the
+// vector. A reorder sorts the records by (sector, Morton code of position),
+// packing each sector's ships together with near neighbors adjacent, then
+// rewires every pointer to them: targets, weapon parents, sector sets and
+// partitions, timers, arrivals and the traffic pool. Iteration orders are
+// kept, so a reordered run is identical to one that isn't (--compare).
+struct ShipLocality
+{
+    size_t reorders;
+    size_t pagesBefore; // pages touched sweeping every sector, before the latest reorder
+    size_t pagesAfter;  // ...and after
+
+    ShipLocality( size_t shipCount );
+    ~ShipLocality();
+
+    Ship&       resolve( ships_t& ships, ShipHandle handle ) const;
+    Ship const& resolve( ships_t const& ships, ShipHandle handle ) const;
+    ShipHandle  handleOf( ships_t const& ships, Ship const* ship ) const;
+
+    void reorder( ships_t& ships, sectors_t& sectors, Schedule& schedule, Traffic& traffic );
+
+    // Memory pages touched walking each sector's live ships the way targeting
+    // does -- a proxy for the cache and TLB misses a scattered layout costs
+    static size_t sweepPages( sectors_t const& sectors );
+
+private:
+    vector<size_t> _indices; // ships_t index by handle
+    vector<size_t> _handles; // handle by ships_t index
+};
+
+
+} // tinyspace
+
+
+#endif // _TINYSPACE_LOCALITY_HPP_
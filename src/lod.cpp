@@ -0,0 +1,180 @@
+// lod.cpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#include "lod.hpp"
+
+#include <limits>
+#include "constants.hpp"
+
+
+namespace tinyspace {
+
+
+namespace {
+unsigned int const UNREACHABLE = std::numeric_limits<unsigned int>::max();
+}
+
+
+LevelOfDetail::LevelOfDetail()
+    : tick( 0 ), fullDistance( LOD_FULL_DISTANCE ), reducedDistance( LOD_REDUCED_DISTANCE ),
+      sectorCounts(), shipCounts(), dormant(), awoken(),
+      _watched(), _distances(), _queue()
+{}
+
+
+LevelOfDetail::~LevelOfDetail()
+{}
+
+
+void LevelOfDetail::searchDistances( sectors_t& sectors, bool useJumpgates )
+{
+    size_t const colCount = sectors.empty() ? 0 : sectors[ 0 ].size();
+
+    _distances.assign( sectors.size() * colCount, UNREACHABLE );
+    _queue.clear();
+    for ( Sector* sector : _watched )
+    {
+        auto& distance = _distances[ sector->rowcol.first * colCount + sector->rowcol.second ];
+        if ( distance )
+        {
+            distance = 0;
+            _queue.push_back( sector );
+        }
+    }
+
+    // multi-source breadth-first search -- _queue only grows, so walk it by index
+    for ( size_t i = 0; i < _queue.size(); ++i )
+    {
+        Sector* sector = _queue[ i ];
+        unsigned int next = _distances[ sector->rowcol.first * colCount + sector->rowcol.second ] + 1;
+
+        sector_ptrs_t adjacent;
+        if ( useJumpgates )
+        {
+            for ( Jumpgate* jumpgate : sector->jumpgates.all() ) adjacent.push_back( jumpgate->target->sector );
+        }
+        else
+        {
+            adjacent = sector->neighbors.all();
+        }
+        for ( Sector* other : adjacent )
+        {
+            auto& distance = _distances[ other->rowcol.first * colCount + other->rowcol.second ];
+            if ( distance == UNREACHABLE )
+            {
+                distance = next;
+                _queue.push_back( other );
+            }
+        }
+    }
+}
+
+
+void LevelOfDetail::relocateSectors( std::function<Sector*( Sector* )> const& relocate )
+{
+    for ( auto sectors : { &dormant, &awoken, &_watched, &_queue } )
+    {
+        for ( auto& sector : *sectors ) sector = relocate( sector );
+    }
+}
+
+
+void LevelOfDetail::update( sectors_t& sectors, sector_ptrs_t const& watched, double delta, bool useJumpgates )
+{
+    // distances only change with the watched set
+    bool initial = _distances.empty();
+    if ( initial || watched != _watched )
+    {
+        _watched = watched;
+        searchDistances( sectors, useJumpgates );
+    }
+
+    ++tick;
+    for ( auto& count : sectorCounts ) count = 0;
+    for ( auto& count : shipCounts )   count = 0;
+    dormant.clear();
+    awoken.clear();
+
+    size_t i = 0;
+    for ( auto& sectorRow : sectors )
+    {
+        for ( auto& sector : sectorRow )
+        {
+            auto& lod = sector.lod;
+            LodTier previous = lod.tier;
+            unsigned int distance = _distances[ i ];
+            LodTier target = distance <= fullDistance    ? LodTier_Full
+                           : distance <= reducedDistance ? LodTier_Reduced
+                           :                               LodTier_Dormant;
+            lod.distance = distance;
+
+            if ( initial || target < lod.tier )
+            {
+                lod.tier = target;
+                lod.hold = LOD_DEMOTE_DELAY;
+            }
+            else if ( target > lod.tier )
+            {
+                if ( lod.hold )
+                {
+                    --lod.hold;
+                }
+                else
+                {
+                    lod.tier = static_cast<LodTier>( lod.tier + 1 );
+                    lod.hold = LOD_DEMOTE_DELAY;
+                }
+            }
+            else
+            {
+                lod.hold = LOD_DEMOTE_DELAY;
+            }
+
+            // time simulated on the last due tick is spent
+            if ( lod.due )
+            {
+                lod.delta = 0.0;
+            }
+            switch ( lod.tier )
+            {
+                case LodTier_Full:
+                    lod.due    = true;
+                    lod.delta += delta;
+                    break;
+                case LodTier_Reduced:
+                    lod.due    = ( tick + i ) % LOD_REDUCED_INTERVAL == 0;
+                    lod.delta += delta;
+                    break;
+                default:
+                    // dormant sectors are frozen -- nothing accrues
+                    lod.due   = false;
+                    lod.delta = 0.0;
+                    break;
+            }
+
+            if ( lod.tier == LodTier_Dormant && previous != LodTier_Dormant )
+            {
+                dormant.push_back( &sector );
+            }
+            else if ( lod.tier != LodTier_Dormant && previous == LodTier_Dormant )
+            {
+                awoken.push_back( &sector );
+            }
+
+            ++sectorCounts[ lod.tier ];
+            if ( lod.due )
+            {
+                // docked and dead ships only wait on timers
+                for ( size_t faction = 0; faction < ShipFaction_END; ++faction )
+                {
+                    shipCounts[ lod.tier ] += sector.stateShips( ShipState_Flying, static_cast<ShipFaction>( faction )).size();
+                }
+            }
+            ++i;
+        }
+    }
+}
+
+
+} // tinyspace
@@ -0,0 +1,57 @@
+// lod.hpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#ifndef _TINYSPACE_LOD_HPP_
+#define _TINYSPACE_LOD_HPP_
+
+
+#include "models.hpp"
+#include "types.hpp"
+
+
+namespace tinyspace {
+
+
+// Sector level-of-detail scheduling.
+//
+// Sectors are tiered by graph distance (jumpgate hops, or grid steps without
+// jumpgates) from the nearest watched sector. Promotion is immediate, while
+// demotion waits LOD_DEMOTE_DELAY ticks and drops one tier at a time, so a
+// sector the player is approaching is always warmed up a tier ahead. The
+// distances start at LOD_FULL_DISTANCE and LOD_REDUCED_DISTANCE and may be
+// narrowed to shed load (see budget.hpp). Reduced
+// sectors are staggered across the interval to even out the per-tick load.
+struct LevelOfDetail
+{
+    size_t tick;
+    unsigned int fullDistance;          // hops from a watched sector kept at full detail
+    unsigned int reducedDistance;       // hops from a watched sector kept at reduced detail
+    size_t sectorCounts[ LodTier_END ]; // sectors per tier
+    size_t shipCounts[ LodTier_END ];   // flying ships in sectors simulated this tick, per tier
+    sector_ptrs_t dormant;              // sectors that went dormant this tick
+    sector_ptrs_t awoken;               // sectors that left dormancy this tick
+
+    LevelOfDetail();
+    ~LevelOfDetail();
+
+    // Re-tiers the sectors and marks the ones due this tick
+    void update( sectors_t& sectors, sector_ptrs_t const& watched, double delta, bool useJumpgates );
+
+    // Points every held sector at its counterpart in a copy of the world
+    // (see world.hpp) -- tiers and distances carry over as they are
+    void relocateSectors( std::function<Sector*( Sector* )> const& relocate );
+
+private:
+    sector_ptrs_t        _watched;   // watched sectors as of the last distance search
+    vector<unsigned int> _distances; // hops from the nearest watched sector, by row*cols+col
+    sector_ptrs_t        _queue;     // search scratch
+
+    void searchDistances( sectors_t& sectors, bool useJumpgates );
+};
+
+
+} // tinyspace
+
+
+#endif // _TINYSPACE_LOD_HPP_
@@ -18,30 +18,55 @@
 //           2022.02.21 | AUTHOR: xixas | Split files for readability
 
 
+#include <algorithm>
 #include <atomic>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <thread>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "actions.hpp"
+#include "autosave.hpp"
+#include "budget.hpp"
 #include "constants.hpp"
 #include "init.hpp"
+#include "locality.hpp"
+#include "lod.hpp"
+#include "pingpong.hpp"
+#include "rand.hpp"
+#include "replay.hpp"
+#include "replica.hpp"
+#include "schedule.hpp"
+#include "statehash.hpp"
+#include "traffic.hpp"
 #include "types.hpp"
 #include "ui.hpp"
 #include "vector2.hpp"
+#include "world.hpp"
 
 
 using namespace tinyspace;
 using std::atomic;
+using std::cerr;
+using std::clog;
 using std::chrono::duration;
 using std::chrono::milliseconds;
 using std::chrono::steady_clock;
 using std::chrono::time_point;
 using std::cout;
 using std::endl;
-using std::ofstream;
 using std::ostream;
+using std::string;
 using std::thread;
+using std::vector;
 
 
 // ---------------------------------------------------------------------------
@@ -49,27 +74,204 @@ using std::thread;
 // ---------------------------------------------------------------------------
 
 
-int main( int argc, char** argv )
+namespace {
+
+
+struct Options
+{
+    ReplayConfig config;
+    bool         hasSeed       = false;
+    bool         useColor      = false;
+    bool         useHeadless   = false;
+    double       budgetTime    = TICK_TIME;          // milliseconds
+    size_t       headlessTicks = 1000;
+    double       headlessDelta = TICK_TIME / 1000.0; // seconds
+    size_t       hashEvery     = 0;                  // ticks between state hashes (0 = off)
+    size_t       reorderEvery  = 0;                  // ticks between ship storage reorders (0 = off)
+    double       saveEvery     = 0.0;                // sim seconds between background saves (0 = off)
+    string       savePath      = "savegame.xml";
+    SnapshotEngine snapshotEngine = SnapshotEngine_Saveable; // where a save's image of the world comes from
+    string       recordPath;
+    string       replayPath;
+    bool         isCompare     = false;
+    string       compareArgs;                        // options the second run of a comparison adds
+    string       publishName;                        // stream ticks go out on for a replica (replica.hpp)
+    string       replicaName;                        // stream a replica follows until its primary is gone
+};
+
+
+// Receives the tick number and state hash every hashEvery ticks
+typedef std::function<void( size_t tick, uint64_t hash )> hash_fn_t;
+
+
+// False, having said why, on an option value that names nothing
+bool parseOptions( vector<string> const& args, Options& options )
+{
+    auto& config = options.config;
+    string engineName = snapshotEngineName( options.snapshotEngine );
+    for ( size_t i=0; i<args.size(); ++i )
+    {
+        char const* arg = args[i].c_str();
+        bool hasValue   = i+1 < args.size();
+        if ( strcmp(arg, "--budget" ) == 0 && hasValue )    options.budgetTime    = atof( args[++i].c_str() );
+        if ( strcmp(arg, "--ticks" ) == 0 && hasValue )     options.headlessTicks = strtoul( args[++i].c_str(), nullptr, 10 );
+        if ( strcmp(arg, "--dt" ) == 0 && hasValue )        options.headlessDelta = atof( args[++i].c_str() );
+        if ( strcmp(arg, "--seed" ) == 0 && hasValue )      config.seed           = strtoull( args[++i].c_str(), nullptr, 10 ), options.hasSeed = true;
+        if ( strcmp(arg, "--record" ) == 0 && hasValue )    options.recordPath    = args[++i];
+        if ( strcmp(arg, "--replay" ) == 0 && hasValue )    options.replayPath    = args[++i];
+        if ( strcmp(arg, "--hash-every" ) == 0 && hasValue) options.hashEvery     = strtoul( args[++i].c_str(), nullptr, 10 );
+        if ( strcmp(arg, "--reorder" ) == 0 && hasValue )   options.reorderEvery  = strtoul( args[++i].c_str(), nullptr, 10 );
+        if ( strcmp(arg, "--save-every" ) == 0 && hasValue) options.saveEvery     = atof( args[++i].c_str() );
+        if ( strcmp(arg, "--save-path" ) == 0 && hasValue ) options.savePath      = args[++i];
+        if ( strcmp(arg, "--snapshot-engine" ) == 0 && hasValue ) engineName = args[++i];
+        if ( strncmp(arg, "--snapshot-engine=", 18 ) == 0 )      engineName = arg + 18;
+        if ( strcmp(arg, "--compare" ) == 0 && hasValue )   options.compareArgs   = args[++i], options.isCompare = true;
+        if ( strcmp(arg, "--publish" ) == 0 && hasValue )   options.publishName   = args[++i];
+        if ( strcmp(arg, "--replica" ) == 0 && hasValue )   options.replicaName   = args[++i];
+        if ( strcmp(arg, "--headless" ) == 0)     options.useHeadless  = true;
+        if ( strcmp(arg, "--color") == 0 )        options.useColor     = true;
+        if ( strcmp(arg, "--no-jumpgates" ) == 0) config.useJumpgates  = false;
+        if ( strcmp(arg, "--kinetic" ) == 0)      config.useKinetic    = true;
+        if ( strcmp(arg, "--shot-combat" ) == 0)  config.useShotCombat = true;
+        if ( strcmp(arg, "--double-buffer" ) == 0) config.useDoubleBuffer = true;
+    }
+    options.snapshotEngine = snapshotEngineNamed( engineName );
+    if ( options.snapshotEngine == SnapshotEngine_END )
+    {
+        cerr << "unknown snapshot engine '" << engineName << "' (saveable, fork)" << endl;
+        return false;
+    }
+    return true;
+}
+
+
+int run( Options options, hash_fn_t const& onHash )
 {
-    std::srand( time( nullptr ));
+    ReplayConfig&  config = options.config;
+    ReplayRecorder recorder;
+    ReplayPlayer   player;
+
+    bool const   useColor      = options.useColor;
+    bool         useHeadless   = options.useHeadless;
+    double const budgetTime    = options.budgetTime;
+    size_t const headlessTicks = options.headlessTicks;
+    double const headlessDelta = options.headlessDelta;
+    string const recordPath    = options.recordPath;
+    string const replayPath    = options.replayPath;
+
+    // A replay runs headless on the recorded config, for as many ticks as it holds
+    bool isReplay = ! replayPath.empty();
+    if ( isReplay )
+    {
+        if ( ! player.open( replayPath, config ))
+        {
+            cerr << "cannot replay " << replayPath << endl;
+            return 1;
+        }
+        useHeadless = true;
+    }
+    else if ( ! options.hasSeed )
+    {
+        config.seed = time( nullptr );
+    }
+
+    // A replica runs on its primary's config
+    Replica replica;
+    bool const isReplica = ! options.replicaName.empty();
+    if ( isReplica && ( isReplay || options.replicaName == options.publishName ))
+    {
+        cerr << "a replica can't replay, or publish as the primary it follows" << endl;
+        return 1;
+    }
+    if ( isReplica && ! replica.attach( options.replicaName, config ))
+    {
+        cerr << "no primary publishing as " << options.replicaName << endl;
+        return 1;
+    }
+    if ( ! recordPath.empty() && ! recorder.open( recordPath, config ))
+    {
+        cerr << "cannot record to " << recordPath << endl;
+        return 1;
+    }
+    seedRand( config.seed );
+
+    World world( config, SHIP_COUNT, SECTOR_BOUNDS, SECTOR_SIZE );
+    auto& sectors   = world.sectors;
+    auto& jumpgates = world.jumpgates;
+    auto& stations  = world.stations;
+    auto& ships     = world.ships;
+    auto& locality  = world.locality;
+    auto& schedule  = world.schedule;
+    auto& lod       = world.lod;
+    auto& traffic   = world.traffic;
+
+    // ship records move when storage is reordered -- the player's is
+    // re-resolved from its handle after each reorder
+    ShipHandle const playerHandle = world.playerHandle;
+    Ship*&           playerShip   = world.player;
+
+    // double buffered, the Saveable slots carry each tick's front -- saves fork
+    SnapshotEngine snapshotEngine = options.snapshotEngine;
+    if ( config.useDoubleBuffer && options.saveEvery > 0.0 && snapshotEngine == SnapshotEngine_Saveable )
+    {
+        clog << "save: double buffered, saving by fork snapshot" << endl;
+        snapshotEngine = SnapshotEngine_Fork;
+    }
 
-    ofstream livefile, snapfile;
+    TickBudget    budget( budgetTime / 1000 );
+    Autosave      autosave( options.saveEvery, options.savePath, snapshotEngine );
+    TickBuffers   buffers( config.useDoubleBuffer );
 
-    bool useColor     = false;
-    bool useJumpgates = true;
+    double phases[ TickPhase_END ] = {}; // seconds spent in each phase of the latest tick
+    size_t tickCount = 0;
 
-    for ( size_t i=0; i<argc; ++i )
+    ReplicaFeed feed( options.publishName, config );
+    if ( ! options.publishName.empty() && ! feed.isOpen() )
     {
-        if ( strcmp(argv[i], "--color") == 0 )        useColor     = true;
-        if ( strcmp(argv[i], "--no-jumpgates" ) == 0) useJumpgates = false;
+        cerr << "cannot publish as " << options.publishName << endl;
+        return 1;
     }
 
-    auto sectors   = initSectors( SECTOR_BOUNDS, SECTOR_SIZE );
-    auto jumpgates = initJumpgates( sectors, useJumpgates );
-    auto stations  = initStations( sectors );
-    auto ships     = initShips( SHIP_COUNT, sectors, useJumpgates );
+    // Runs a tick phase and records its time in phases[]
+    auto timed = [ & ]( TickPhase phase, std::function<void()> fn )
+    {
+        auto start = steady_clock::now();
+        fn();
+        phases[ phase ] = duration<double>( steady_clock::now() - start ).count();
+    };
+
+    // Advances the simulation one tick
+    auto simulate = [ & ]( double delta )
+    {
+        buffers.open();
+        autosave.update( schedule.time, sectors, jumpgates, stations, ships, clog );
+        auto start = steady_clock::now();
 
-    auto& playerShip = ships[0];
+        world.advance( delta, phases );
+        buffers.swap();
+
+        ++tickCount;
+        phases[ TickPhase_Publish ] = 0.0;
+        if ( feed.isOpen() )
+        {
+            timed( TickPhase_Publish, [ & ]() { feed.publish( tickCount, ReplayTick( delta, budget.level ), world ); });
+        }
+        phases[ TickPhase_Locality ] = 0.0;
+        // a save in flight walks the records in place -- the reorder waits a round
+        if ( options.reorderEvery && tickCount % options.reorderEvery == 0 && ! autosave.isBusy() )
+        {
+            timed( TickPhase_Locality, [ & ]()
+            {
+                locality.reorder( ships, sectors, schedule, traffic );
+                playerShip = &locality.resolve( ships, playerHandle );
+            });
+        }
+        if ( options.hashEvery && tickCount % options.hashEvery == 0 )
+        {
+            onHash( tickCount, hashState( schedule, sectors, ships, locality ));
+        }
+        autosave.recordTick( duration<double>( steady_clock::now() - start ).count() );
+    };
 
     auto mainThreadFn = [ & ]()
     {
@@ -84,27 +286,336 @@ int main( int argc, char** argv )
             delta      = thisTick - lastTick; // seconds
             nextTick   = thisTick + milliseconds(TICK_TIME);
 
+            // a stalled tick is simulated no further than MAX_TICK_DELTA, so
+            // one slow tick can't snowball into ever larger catch-up steps
+            ReplayTick tick( std::min( delta.count(), MAX_TICK_DELTA ), budget.level );
+            if ( recorder.isOpen() ) recorder.record( tick );
+
             t = steady_clock::now();
-            respawnShips( ships, &playerShip, stations, useJumpgates );
-            moveShips( delta.count(), ships, &playerShip, useJumpgates );
-            acquireTargets( sectors );
-            fireWeapons( delta.count(), ships );
+            simulate( tick.delta );
             d1 = steady_clock::now() - t;
-            
-            t = steady_clock::now();
-            updateDisplay( cout, sectors, playerShip, useColor );
-            d2 = steady_clock::now() - t;
-            
+
+            bool isDisplayDue = budget.isDisplayDue();
+            phases[ TickPhase_Display ] = 0.0;
+            if ( isDisplayDue )
+            {
+                timed( TickPhase_Display, [ & ]()
+                {
+                    syncPositions( *playerShip->sector, schedule.time );
+                    updateDisplay( cout, sectors, *playerShip, useColor, schedule.time );
+                });
+            }
+            d2 = duration<double>( phases[ TickPhase_Display ] );
+
+            budget.update( phases, lod, schedule, clog );
+
+            lastTick = thisTick;
+            if ( ! isDisplayDue )
+            {
+                continue;
+            }
+
             cout << "delta: "   << ( delta.count() * 1000 ) << "ms" << "  "
                  << "work: "    << ( d1.count() * 1000 )    << "ms" << "  "
-                 << "display: " << ( d2.count() * 1000 )    << "ms" << endl;
+                 << "display: " << ( d2.count() * 1000 )    << "ms" << "  "
+                 << "budget: "  << ( budget.load() * 1000 ) << "/" << budgetTime << "ms"
+                 << " (" << budgetLevelName( budget.level ) << ")  "
+                 << "lod sectors (full/reduced/dormant): "
+                 << lod.sectorCounts[ LodTier_Full ] << "/"
+                 << lod.sectorCounts[ LodTier_Reduced ] << "/"
+                 << lod.sectorCounts[ LodTier_Dormant ] << "  "
+                 << "ship updates: "
+                 << lod.shipCounts[ LodTier_Full ] << "/"
+                 << lod.shipCounts[ LodTier_Reduced ] << "  "
+                 << "parked: "  << traffic.parkedCount() << endl;
+        }
+    };
 
-            lastTick = thisTick;
+    // Headless -- fixed steps as fast as they'll run, at full fidelity (no
+    // budget shedding) so runs are comparable, then a throughput report.
+    // Replays feed the recorded ticks instead, shed levels included.
+    auto headlessThreadFn = [ & ]()
+    {
+        double totals[ TickPhase_END ] = {}; // seconds
+        size_t shipUpdates = 0;
+        ReplayTick tick( headlessDelta );
+        size_t const firstTick = tickCount; // where a replica took over
+
+        auto start = steady_clock::now();
+        while ( isReplay ? player.next( tick ) : tickCount < headlessTicks )
+        {
+            budget.setLevel( tick.level, lod, schedule );
+            if ( recorder.isOpen() ) recorder.record( tick );
+            simulate( tick.delta );
+            for ( size_t phase = 0; phase < TickPhase_Display; ++phase ) totals[ phase ] += phases[ phase ];
+            for ( auto count : lod.shipCounts ) shipUpdates += count;
+        }
+        double elapsed = duration<double>( steady_clock::now() - start ).count();
+        size_t ran     = tickCount - firstTick;
+        autosave.finish( clog );
+
+        double work = 0.0;
+        for ( auto total : totals ) work += total;
+
+        struct rusage usage;
+        getrusage( RUSAGE_SELF, &usage );
+
+        size_t fleet[ ShipState_END ] = {};
+        for ( auto& ship : ships ) if ( ! ship.parked ) ++fleet[ ship.currentState() ];
+
+        cout << "seed: "         << config.seed << endl
+             << "ticks: "        << tickCount;
+        if ( ! isReplay ) cout << " x " << headlessDelta << "s";
+        cout << " (" << schedule.time << "s simulated)" << endl
+             << "ships: "        << fleet[ ShipState_Flying ] << " flying, "
+                                 << fleet[ ShipState_Docked ] << " docked, "
+                                 << fleet[ ShipState_Dead ]   << " dead, "
+                                 << traffic.parkedCount()     << " parked" << endl
+             << "wall: "         << elapsed << "s" << endl
+             << "ticks/s: "      << ( ran / elapsed ) << endl
+             << "ship updates/s: " << ( shipUpdates / elapsed ) << endl;
+        for ( size_t phase = 0; phase < TickPhase_Display; ++phase )
+        {
+            cout << "  " << tickPhaseName( static_cast<TickPhase>( phase )) << ": "
+                 << ( totals[ phase ] * 1000 / std::max<size_t>( ran, 1 )) << "ms/tick"
+                 << " (" << ( work > 0.0 ? totals[ phase ] * 100 / work : 0.0 ) << "%)" << endl;
+        }
+        if ( locality.reorders )
+        {
+            cout << "locality: " << locality.reorders << " reorders, sector sweep "
+                 << locality.pagesBefore << " -> " << locality.pagesAfter << " pages (last reorder), "
+                 << ShipLocality::sweepPages( sectors ) << " now" << endl;
+        }
+        if ( autosave.interval > 0.0 )
+        {
+            bool   isFork   = autosave.engine == SnapshotEngine_Fork;
+            double busyTick = autosave.busyTicks ? autosave.busyTickTime / autosave.busyTicks : 0.0;
+            cout << "autosave: " << autosave.saves << " saves every " << autosave.interval << "s"
+                 << " by " << snapshotEngineName( autosave.engine ) << " snapshot"
+                 << " (" << ( autosave.bytes / 1024 ) << "KB, ";
+            if ( ! isFork ) cout << autosave.diverged << " fields diverged, ";
+            cout << ( autosave.saves ? autosave.saveTime * 1000 / autosave.saves : 0.0 ) << "ms/save "
+                 << ( isFork ? "child cpu" : "off-thread" ) << ")";
+            if ( autosave.failures ) cout << ", " << autosave.failures << " failed";
+            if ( autosave.deferred ) cout << ", " << autosave.deferred << " ticks deferred at the fork cap";
+            cout << endl;
+            // measured against the warm idle ticks before each save started
+            if ( autosave.hasStall() )
+            {
+                cout << "  tick while saving: " << ( autosave.baseline() + autosave.stall() ) * 1000 << "ms"
+                     << " vs " << ( autosave.baseline() * 1000 ) << "ms idle"
+                     << " (stall " << ( autosave.stall() * 1000 ) << "ms over " << autosave.stallTicks << " ticks, ";
+            }
+            else
+            {
+                cout << "  tick while saving: " << ( busyTick * 1000 ) << "ms (stall n/a -- too few warm idle ticks, ";
+            }
+            cout << "max " << ( autosave.maxBusyTick * 1000 ) << "ms)"
+                 << ", " << ( isFork ? "fork" : "start/reconcile" ) << " "
+                 << ( autosave.saves ? autosave.pauseTime * 1000 / autosave.saves : 0.0 ) << "ms/save"
+                 << " (max " << ( autosave.maxPause * 1000 ) << "ms)" << endl;
+            if ( isFork )
+            {
+                cout << "  page faults per tick: "
+                     << ( autosave.busyTicks ? double( autosave.busyFaults ) / autosave.busyTicks : 0.0 ) << " while saving vs "
+                     << ( autosave.idleTicks ? double( autosave.idleFaults ) / autosave.idleTicks : 0.0 ) << " idle" << endl;
+            }
+        }
+        if ( buffers.isEnabled )
+        {
+            cout << "double buffer: " << buffers.swaps << " swaps, " << buffers.diverged << " fields written by the last tick, "
+                 << ( buffers.swaps ? buffers.swapTime * 1000 / buffers.swaps : 0.0 ) << "ms/swap"
+                 << " (max " << ( buffers.maxSwap * 1000 ) << "ms)" << endl;
+        }
+        if ( feed.isOpen() )
+        {
+            cout << "replica feed: " << feed.records << " ticks published (" << feed.checks << " with a state hash), "
+                 << feed.dropped << " dropped" << endl;
         }
+        cout << "peak rss: "     << usage.ru_maxrss << "KB" << endl; // kilobytes on Linux
     };
 
-    thread mainThread = thread( mainThreadFn );
+    // A replica steps its primary's ticks as they come, and carries on from
+    // the last one once the primary is gone
+    if ( isReplica )
+    {
+        clog << "replica: following " << options.replicaName << " (seed " << config.seed << ")" << endl;
+        ReplayTick tick;
+        while ( replica.next( tick ))
+        {
+            budget.setLevel( tick.level, lod, schedule );
+            if ( recorder.isOpen() ) recorder.record( tick );
+            simulate( tick.delta );
+            if ( ! replica.check( world )) break;
+        }
+        if ( ! replica.error().empty() )
+        {
+            cerr << "replica: " << replica.error() << endl;
+            return 1;
+        }
+        replica.takeOver();
+        clog << "replica: took over at tick " << tickCount << " (" << replica.ticks << " ticks followed)" << endl;
+    }
+
+    thread mainThread = useHeadless ? thread( headlessThreadFn ) : thread( mainThreadFn );
     mainThread.join();
 
     return 0;
 }
+
+
+// Reads exactly size bytes -- false at end of stream
+bool readAll( int fd, void* data, size_t size )
+{
+    char* p = static_cast<char*>( data );
+    while ( size )
+    {
+        ssize_t n = read( fd, p, size );
+        if ( n <= 0 ) return false;
+        p    += n;
+        size -= n;
+    }
+    return true;
+}
+
+
+// Runs the options and the options plus compareArgs side by side, headless
+// and on the same seed, each in a forked child streaming its state hashes
+// back over a pipe. Reports the first hashed tick where they disagree.
+// Returns 0 if the runs match throughout, 1 if they diverge.
+int compare( Options options )
+{
+    // the seed is reported, so a replay's comes from its header
+    if ( ! options.replayPath.empty() )
+    {
+        ReplayPlayer header;
+        if ( ! header.open( options.replayPath, options.config ))
+        {
+            cerr << "cannot replay " << options.replayPath << endl;
+            return 2;
+        }
+    }
+    else if ( ! options.hasSeed )
+    {
+        options.config.seed = time( nullptr );
+        options.hasSeed     = true;
+    }
+    options.useHeadless = true;
+    options.recordPath.clear();
+    if ( ! options.hashEvery )
+    {
+        options.hashEvery = 1;
+    }
+
+    vector<string> args;
+    std::istringstream is( options.compareArgs );
+    for ( string arg; is >> arg; ) args.push_back( arg );
+    options.isCompare = false;
+
+    Options runs[ 2 ] = { options, options };
+    if ( ! parseOptions( args, runs[ 1 ] ))
+    {
+        return 1;
+    }
+    runs[ 1 ].isCompare = false;
+
+    struct HashRecord { uint64_t tick, hash; };
+    pid_t pids[ 2 ];
+    int   fds[ 2 ];
+    for ( size_t i = 0; i < 2; ++i )
+    {
+        int pipefd[ 2 ];
+        if ( pipe( pipefd ) != 0 )
+        {
+            cerr << "compare: cannot create pipe" << endl;
+            return 2;
+        }
+        pids[ i ] = fork();
+        if ( pids[ i ] == 0 )
+        {
+            // child -- reports go nowhere, hashes go up the pipe
+            close( pipefd[ 0 ] );
+            if ( i ) close( fds[ 0 ] );
+            int devnull = open( "/dev/null", O_WRONLY );
+            dup2( devnull, STDOUT_FILENO );
+            int status = run( runs[ i ], [ & ]( size_t tick, uint64_t hash )
+            {
+                HashRecord record { tick, hash };
+                if ( write( pipefd[ 1 ], &record, sizeof( record )) != sizeof( record )) _exit( 2 );
+            });
+            _exit( status );
+        }
+        close( pipefd[ 1 ] );
+        fds[ i ] = pipefd[ 0 ];
+    }
+
+    int result = 0;
+    HashRecord records[ 2 ];
+    size_t compared = 0;
+    while ( true )
+    {
+        bool hasA = readAll( fds[ 0 ], &records[ 0 ], sizeof( HashRecord ));
+        bool hasB = readAll( fds[ 1 ], &records[ 1 ], sizeof( HashRecord ));
+        if ( ! hasA && ! hasB )
+        {
+            cout << "identical: " << compared << " hashes over both runs (seed " << options.config.seed << ")" << endl;
+            break;
+        }
+        if ( hasA != hasB )
+        {
+            cout << "diverged: run " << ( hasA ? "B" : "A" ) << " ended after " << compared << " hashes"
+                 << " (seed " << options.config.seed << ")" << endl;
+            result = 1;
+            break;
+        }
+        if ( records[ 0 ].tick != records[ 1 ].tick || records[ 0 ].hash != records[ 1 ].hash )
+        {
+            cout << std::hex << std::setfill( '0' )
+                 << "diverged at tick " << std::dec << records[ 0 ].tick << std::hex << ": "
+                 << "A " << std::setw( 16 ) << records[ 0 ].hash << "  "
+                 << "B " << std::setw( 16 ) << records[ 1 ].hash
+                 << std::dec << " (seed " << options.config.seed << ")" << endl;
+            result = 1;
+            break;
+        }
+        ++compared;
+    }
+
+    for ( size_t i = 0; i < 2; ++i )
+    {
+        close( fds[ i ] );
+        if ( result ) kill( pids[ i ], SIGTERM );
+        waitpid( pids[ i ], nullptr, 0 );
+    }
+    return result;
+}
+
+
+} // anonymous
+
+
+// ---------------------------------------------------------------------------
+
+
+int main( int argc, char** argv )
+{
+    Options options;
+    if ( ! parseOptions( vector<string>( argv + 1, argv + argc ), options ))
+    {
+        return 1;
+    }
+
+    if ( options.isCompare )
+    {
+        return compare( options );
+    }
+
+    // headless hashes share stdout with the report -- interactive stdout is the display
+    ostream& hashLog = options.useHeadless || ! options.replayPath.empty() ? cout : clog;
+    return run( options, [ & ]( size_t tick, uint64_t hash )
+    {
+        hashLog << "hash " << tick << " "
+                << std::hex << std::setfill( '0' ) << std::setw( 16 ) << hash
+                << std::dec << std::setfill( ' ' ) << '\n';
+    });
+}
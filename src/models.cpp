@@ -4,6 +4,9 @@
 
 #include "models.hpp"
 
+#include <algorithm>
+#include "constants.hpp"
+
 
 namespace tinyspace {
 
@@ -13,7 +16,7 @@ namespace tinyspace {
 // ---------------------------------------------------------------------------
 
 
-id_t HasID::curId = 0;
+__thread id_t HasID::curId = 0;
 
 
 HasID::HasID( IdType const& idType )
@@ -38,6 +41,18 @@ void HasID::resetId()
 }
 
 
+id_t HasID::lastId()
+{
+    return curId;
+}
+
+
+void HasID::setLastId( id_t id )
+{
+    curId = id;
+}
+
+
 // ---------------------------------------------------------------------------
 // HasCode
 // ---------------------------------------------------------------------------
@@ -191,6 +206,26 @@ HasDestination::~HasDestination()
 {}
 
 
+// ---------------------------------------------------------------------------
+// HasTrajectory
+// ---------------------------------------------------------------------------
+
+
+HasTrajectory::HasTrajectory()
+    : origin(), departure( -1.0 ), arrival( -1.0 )
+{}
+
+
+HasTrajectory::~HasTrajectory()
+{}
+
+
+bool HasTrajectory::inFlight() const
+{
+    return departure >= 0.0;
+}
+
+
 // ---------------------------------------------------------------------------
 // SectorNeighbors
 // ---------------------------------------------------------------------------
@@ -259,6 +294,53 @@ jumpgate_ptrs_t SectorJumpgates::all( bool includeNull ) const
 };
 
 
+// ---------------------------------------------------------------------------
+// SectorLod
+// ---------------------------------------------------------------------------
+
+
+SectorLod::SectorLod()
+    : tier( LodTier_Full ), distance( 0 ), hold( 0 ), delta( 0.0 ), due( true )
+{}
+
+
+SectorLod::~SectorLod()
+{}
+
+
+// ---------------------------------------------------------------------------
+// SectorTraffic
+// ---------------------------------------------------------------------------
+
+
+SectorTraffic::SectorTraffic()
+    : counts(), delta( 0.0 )
+{}
+
+
+SectorTraffic::~SectorTraffic()
+{}
+
+
+size_t SectorTraffic::total() const
+{
+    size_t r = 0;
+    for ( size_t faction = 0; faction < ShipFaction_END; ++faction )
+    {
+        r += total( static_cast<ShipFaction>( faction ));
+    }
+    return r;
+}
+
+
+size_t SectorTraffic::total( ShipFaction faction ) const
+{
+    size_t r = 0;
+    for ( auto count : counts[ faction ] ) r += count;
+    return r;
+}
+
+
 // ---------------------------------------------------------------------------
 // Sector
 // ---------------------------------------------------------------------------
@@ -274,7 +356,14 @@ Sector::Sector(
     HasSize( size ),
     rowcol( rowcol ),
     neighbors(),
-    _ships()
+    lod(),
+    traffic(),
+    routes( nullptr ),
+    isTargeting( false ),
+    _ships(),
+    _partitions(),
+    _factionsPresent( 0 ),
+    _isContested( false )
 {}
 
 
@@ -289,17 +378,172 @@ Sector::Sector(
     HasSize( size ),
     rowcol( rowcol ),
     neighbors(),
-    _ships()
+    lod(),
+    traffic(),
+    routes( nullptr ),
+    isTargeting( false ),
+    _ships(),
+    _partitions(),
+    _factionsPresent( 0 ),
+    _isContested( false )
 {}
 
 
+Sector::Sector( Sector const& o )
+    :
+    HasID( o.id, IdType_Sector ),
+    HasName( o.name ),
+    HasSize( o.size ),
+    rowcol( o.rowcol ),
+    neighbors( o.neighbors ),
+    jumpgates( o.jumpgates ),
+    lod( o.lod ),
+    traffic( o.traffic ),
+    stations( o.stations ),
+    routes( o.routes ),
+    isTargeting( o.isTargeting ),
+    _ships( o._ships ),
+    _factionsPresent( o._factionsPresent ),
+    _isContested( o._isContested )
+{
+    for ( size_t state = 0; state < ShipState_END; ++state )
+    {
+        for ( size_t faction = 0; faction < ShipFaction_END; ++faction )
+        {
+            _partitions[ state ][ faction ] = o._partitions[ state ][ faction ];
+        }
+    }
+}
+
+
 Sector::~Sector()
 {}
 
 
 void Sector::setShips( ship_ptrs_set_t&& ships )
 {
-    _ships = ships;
+    _ships = ship_ptrs_pset_t( ships.begin(), ships.end() );
+
+    for ( auto& partitions : _partitions )
+    {
+        for ( auto& partition : partitions )
+        {
+            partition.clear();
+        }
+    }
+    for ( Ship* ship : _ships() )
+    {
+        file( ship );
+    }
+    updatePresence();
+}
+
+
+void Sector::addShip( Ship* ship )
+{
+    if ( _ships.edit().insert( ship ))
+    {
+        file( ship );
+        updatePresence();
+    }
+}
+
+
+void Sector::removeShip( Ship* ship )
+{
+    if ( _ships.edit().erase( ship ))
+    {
+        unfile( ship );
+        updatePresence();
+    }
+}
+
+
+void Sector::updateShip( Ship* ship )
+{
+    if ( ship->state != ship->currentState() )
+    {
+        unfile( ship );
+        file( ship );
+        updatePresence();
+    }
+}
+
+
+void Sector::relocateShips( std::function<Ship*( Ship* )> const& relocate )
+{
+    ship_ptrs_pset_t ships;
+    for ( Ship* ship : _ships() ) ships.insert( relocate( ship ));
+    _ships = std::move( ships );
+
+    for ( auto& statePartitions : _partitions )
+    {
+        for ( auto& partition : statePartitions )
+        {
+            for ( auto& ship : partition ) ship = relocate( ship );
+        }
+    }
+}
+
+
+ship_ptrs_t const& Sector::stateShips( ShipState state, ShipFaction faction ) const
+{
+    return _partitions[ state ][ faction ];
+}
+
+
+void Sector::file( Ship* ship )
+{
+    auto& partition = _partitions[ ship->currentState() ][ ship->faction ];
+    ship->state     = ship->currentState();
+    ship->stateSlot = partition.size();
+    partition.push_back( ship );
+}
+
+
+// O(1) -- the partition's last ship takes over the slot
+void Sector::unfile( Ship* ship )
+{
+    auto& partition = _partitions[ ship->state ][ ship->faction ];
+    Ship* last = partition.back();
+    partition[ ship->stateSlot ] = last;
+    last->stateSlot = ship->stateSlot;
+    partition.pop_back();
+}
+
+
+void Sector::updatePresence()
+{
+    _factionsPresent = 0;
+    for ( size_t faction = 0; faction < ShipFaction_END; ++faction )
+    {
+        if ( ! _partitions[ ShipState_Flying ][ faction ].empty()
+        ||   ! _partitions[ ShipState_Docked ][ faction ].empty() )
+        {
+            _factionsPresent |= factionBit( static_cast<ShipFaction>( faction ));
+        }
+    }
+    _isContested = false;
+    for ( size_t faction = 0; faction < ShipFaction_END; ++faction )
+    {
+        if (( _factionsPresent & factionBit( static_cast<ShipFaction>( faction )))
+        &&  ( FACTION_HOSTILITY[ faction ] & _factionsPresent ))
+        {
+            _isContested = true;
+        }
+    }
+}
+
+
+unsigned int Sector::factionsPresent() const
+{
+    return _factionsPresent;
+}
+
+
+bool Sector::isContested() const
+{
+    return _isContested;
 }
 
 
@@ -399,7 +643,7 @@ Weapon::Weapon(
     isTurret( isTurret ),
     weaponPosition( weaponPosition ),
     parent( &parent ),
-    target( nullptr ), cooldown( 0 )
+    target( nullptr ), readyAt( 0.0 )
 {}
 
 
@@ -409,7 +653,7 @@ Weapon::Weapon(
     bool isTurret,
     WeaponPosition weaponPosition,
     HasIDAndSectorAndPosition& parent,
-    HasIDAndSectorAndPosition* const target, float cooldown )
+    HasIDAndSectorAndPosition* const target, double readyAt )
     :
     HasID( id, IdType_Weapon ),
     type( type ),
@@ -417,7 +661,7 @@ Weapon::Weapon(
     weaponPosition( weaponPosition ),
     parent( &parent ),
     target( target ),
-    cooldown( cooldown )
+    readyAt( readyAt )
 {}
 
 
@@ -438,6 +682,7 @@ Ship::Ship( Ship&& o )
     HasDirection( o.direction ),
     HasSpeed( o.speed ),
     HasDestination( o.destination ),
+    HasTrajectory( o ),
     type( o.type ),
     maxHull( o.maxHull ),
     currentHull( o.currentHull ),
@@ -445,11 +690,54 @@ Ship::Ship( Ship&& o )
     _weapons( std::move( o._weapons )),
     _turrets( std::move( o._turrets )),
     target( o.target ),
+    journey( o.journey ),
     docked( o.docked ),
-    timeout( o.timeout )
+    parked( o.parked ),
+    state( o.state ),
+    stateSlot( o.stateSlot ),
+    timeoutAt( o.timeoutAt )
 {}
 
 
+Ship::Ship( Ship const& o )
+    :
+    HasIDAndSectorAndPosition( o.id, o.idType, o.sector, o.position ),
+    HasName( o.name ),
+    HasCode( o.code ),
+    HasDirection( o.direction ),
+    HasSpeed( o.speed ),
+    HasDestination( o.destination ),
+    HasTrajectory( o ),
+    type( o.type ),
+    maxHull( o.maxHull ),
+    currentHull( o.currentHull ),
+    faction( o.faction ),
+    _weapons(),
+    _turrets(),
+    target( o.target ),
+    journey( o.journey ),
+    docked( o.docked ),
+    parked( o.parked ),
+    state( o.state ),
+    stateSlot( o.stateSlot ),
+    timeoutAt( o.timeoutAt )
+{
+    auto copy = [ this ]( weapon_ptrs_pvec_t const& weapons ) -> weapon_ptrs_t
+    {
+        weapon_ptrs_t copies;
+        copies.reserve( weapons.size() );
+        for ( auto& weapon : weapons )
+        {
+            copies.emplace_back( new Weapon( weapon->id, weapon->type, weapon->isTurret, weapon->weaponPosition,
+                                             *this, weapon->target, weapon->readyAt ));
+        }
+        return copies;
+    };
+    setWeapons( copy( o._weapons() ));
+    setTurrets( copy( o._turrets() ));
+}
+
+
 Ship::Ship( 
     ShipType type, const unsigned int hull,
     string const& code, string const& name,
@@ -463,6 +751,7 @@ Ship::Ship(
     HasDirection( direction ),
     HasSpeed( speed ),
     HasDestination( destination ),
+    HasTrajectory(),
     type( type ),
     maxHull( hull ),
     currentHull( hull ),
@@ -470,8 +759,12 @@ Ship::Ship(
     _weapons(),
     _turrets(),
     target( nullptr ),
+    journey( nullptr ),
     docked( false ),
-    timeout( 0.f )
+    parked( false ),
+    state( ShipState_Flying ),
+    stateSlot( 0 ),
+    timeoutAt( 0.0 )
 {}
 
 
@@ -482,7 +775,7 @@ Ship::Ship(
     Sector* const sector, position_t const& position,
     direction_t const& direction, speed_t const& speed,
     destination_ptr_t destination,
-    HasIDAndSectorAndPosition* target, bool docked, float timeout )
+    HasIDAndSectorAndPosition* target, bool docked, double timeoutAt )
     :
     HasIDAndSectorAndPosition( id, IdType_Ship, sector, position ),
     HasName( name ),
@@ -490,6 +783,7 @@ Ship::Ship(
     HasDirection( direction ),
     HasSpeed( speed ),
     HasDestination( destination ),
+    HasTrajectory(),
     type( type ),
     maxHull( maxHull ),
     currentHull( currentHull ),
@@ -497,8 +791,12 @@ Ship::Ship(
     _weapons(),
     _turrets(),
     target( target ),
+    journey( nullptr ),
     docked( docked ),
-    timeout( timeout )
+    parked( false ),
+    state( ShipState_Flying ),
+    stateSlot( 0 ),
+    timeoutAt( timeoutAt )
 {}
 
 
@@ -512,7 +810,7 @@ void Ship::setWeapons( weapon_ptrs_t&& weapons )
     {
         weapon->isTurret = false;
     }
-    _weapons = weapons;
+    _weapons = weapon_ptrs_pvec_t( weapons );
 }
 
 
@@ -522,7 +820,35 @@ void Ship::setTurrets( weapon_ptrs_t&& turrets )
     {
         turret->isTurret = true;
     }
-    _turrets = turrets;
+    _turrets = weapon_ptrs_pvec_t( turrets );
+}
+
+
+position_t Ship::positionAt( double time ) const
+{
+    if ( ! inFlight() )
+    {
+        return position;
+    }
+    double t = std::max( departure(), std::min( time, arrival() ));
+    return origin() + direction() * static_cast<float>( speed * ( t - departure ));
+}
+
+
+void Ship::syncPosition( double time )
+{
+    if ( inFlight() )
+    {
+        position = positionAt( time );
+    }
+}
+
+
+void Ship::stop( double time )
+{
+    syncPosition( time );
+    departure = -1.0;
+    arrival   = -1.0;
 }
 
 
@@ -537,6 +863,9 @@ Ship& Ship::operator =( Ship&& o )
     direction   = o.direction;
     speed       = o.speed;
     destination = o.destination;
+    origin      = o.origin;
+    departure   = o.departure;
+    arrival     = o.arrival;
 
     type        = o.type;
     maxHull     = o.maxHull;
@@ -545,27 +874,39 @@ Ship& Ship::operator =( Ship&& o )
 
     weapon_ptrs_t weapons;
     weapon_ptrs_t turrets;
-    weapons.reserve( o._weapons.size() );
-    turrets.reserve( o._turrets.size() );
-    for ( auto& weapon : o._weapons ) weapons.push_back( weapon );
-    for ( auto& turret : o._turrets ) turrets.push_back( turret );
+    weapons.reserve( o._weapons->size() );
+    turrets.reserve( o._turrets->size() );
+    for ( auto& weapon : o._weapons() ) weapons.push_back( weapon );
+    for ( auto& turret : o._turrets() ) turrets.push_back( turret );
     setWeapons( std::move( weapons ));
     setTurrets( std::move( turrets ));
 
-    target  = o.target;
-    docked  = o.docked;
-    timeout = o.timeout;
+    target    = o.target;
+    journey   = o.journey;
+    docked    = o.docked;
+    parked    = o.parked;
+    state     = o.state;
+    stateSlot = o.stateSlot;
+    timeoutAt = o.timeoutAt;
 
     return *this;
 }
 
 
+ShipState Ship::currentState() const
+{
+    return currentHull <= 0 ? ShipState_Dead
+         : docked           ? ShipState_Docked
+         :                    ShipState_Flying;
+}
+
+
 weapon_ptrs_t Ship::weaponsAndTurrets()
 {
     weapon_ptrs_t r;
-    r.reserve( weapons.size() + turrets.size() );
-    for ( auto& weapon : _weapons ) r.push_back( weapon );
-    for ( auto& turret : _turrets ) r.push_back( turret );
+    r.reserve( weapons->size() + turrets->size() );
+    for ( auto& weapon : _weapons() ) r.push_back( weapon );
+    for ( auto& turret : _turrets() ) r.push_back( turret );
     return r;
 }
 
@@ -7,6 +7,7 @@
 
 
 #include "types.hpp"
+#include "opt/saveable.hpp"
 
 
 namespace tinyspace {
@@ -31,9 +32,19 @@ enum IdType : unsigned int
 };
 
 
+enum ShipFaction : unsigned int
+{
+    ShipFaction_Neutral,
+    ShipFaction_Player,
+    ShipFaction_Friend,
+    ShipFaction_Foe,
+    ShipFaction_END
+};
+
+
 struct HasID
 {
-    id_t id;
+    Saveable<id_t> id;
     IdType idType;
 
     HasID( IdType const& idType );
@@ -42,14 +53,19 @@ struct HasID
 
     void resetId();
 
+    // The calling thread's id counter -- a world stepping on another thread
+    // carries its own (see world.hpp)
+    static id_t lastId();
+    static void setLastId( id_t id );
+
 private:
-    static id_t curId;
+    static __thread id_t curId;
 };
 
 
 struct HasCode
 {
-    string code;
+    Saveable<string> code;
 
     HasCode( string const& code="" );
     ~HasCode();
@@ -58,7 +74,7 @@ struct HasCode
 
 struct HasName
 {
-    string name;
+    Saveable<string> name;
 
     HasName( string const& name="" );
     ~HasName();
@@ -76,7 +92,7 @@ struct HasSize
 
 struct HasPosition
 {
-    position_t position;
+    SaveableVector2<float> position;
 
     HasPosition( position_t const& position={ 0, 0 } );
     ~HasPosition();
@@ -85,7 +101,7 @@ struct HasPosition
 
 struct HasDirection
 {
-    direction_t direction;
+    SaveableVector2<float> direction;
 
     HasDirection( direction_t const& direction={ 0, 0 } );
     ~HasDirection();
@@ -94,7 +110,7 @@ struct HasDirection
 
 struct HasSpeed
 {
-    speed_t speed;
+    Saveable<speed_t> speed;
 
     HasSpeed( speed_t const& speed=0 );
     ~HasSpeed();
@@ -127,13 +143,27 @@ struct HasIDAndSectorAndPosition : public HasID, public HasSectorAndPosition
 
 struct HasDestination
 {
-    destination_ptr_t destination;
+    Saveable<destination_ptr_t> destination;
 
     HasDestination( destination_ptr_t destination=nullptr );
     ~HasDestination();
 };
 
 
+// Straight-line travel evaluated as a closed-form function of sim time
+struct HasTrajectory
+{
+    SaveableVector2<float> origin;    // position at departure
+    Saveable<double>       departure; // sim time (seconds) the current leg began -- negative when not in flight
+    Saveable<double>       arrival;   // sim time (seconds) the current leg ends
+
+    HasTrajectory();
+    ~HasTrajectory();
+
+    bool inFlight() const;
+};
+
+
 struct SectorNeighbors
 {
     Sector* north;
@@ -163,22 +193,114 @@ struct SectorJumpgates {
 };
 
 
+enum ShipType : unsigned int
+{
+    // ship type in order of priority of target importance, least to greatest,
+    // all civilian ships first
+    ShipType_NONE,
+    ShipType_Courier,
+    ShipType_Transport,
+    ShipType_Scout,
+    ShipType_Corvette,
+    ShipType_Frigate,
+    ShipType_END
+};
+
+
+// Lifecycle partitions sectors file their ships under
+enum ShipState : unsigned int
+{
+    ShipState_Flying,
+    ShipState_Docked,
+    ShipState_Dead, // awaiting respawn
+    ShipState_END
+};
+
+
+enum LodTier : unsigned int
+{
+    LodTier_Full,    // simulated every tick
+    LodTier_Reduced, // simulated every LOD_REDUCED_INTERVAL ticks with the accrued delta
+    LodTier_Dormant, // not simulated
+    LodTier_END
+};
+
+
+// Sector simulation level of detail -- maintained by LevelOfDetail (lod.hpp)
+struct SectorLod
+{
+    LodTier      tier;
+    unsigned int distance; // hops from the nearest watched sector
+    unsigned int hold;     // ticks left before the sector may be demoted
+    double       delta; // seconds to simulate this tick (accrued while skipped)
+    bool         due;   // simulated this tick
+
+    SectorLod();
+    ~SectorLod();
+};
+
+
+// Ships a dormant sector holds as counts -- maintained by Traffic (traffic.hpp)
+struct SectorTraffic
+{
+    unsigned int counts[ ShipFaction_END ][ ShipType_END ];
+    double       delta; // seconds accrued since the last flow step
+
+    SectorTraffic();
+    ~SectorTraffic();
+
+    size_t total() const;
+    size_t total( ShipFaction faction ) const;
+};
+
+
 struct Sector : public HasID, public HasName, public HasSize
 {
-    pair<size_t, size_t>   rowcol; // row and column in the universe (sectors)
-    SectorNeighbors        neighbors;
-    SectorJumpgates        jumpgates;
-    station_ptrs_set_t     stations;
-    ship_ptrs_set_t const& ships = _ships;
+    pair<size_t, size_t>              rowcol; // row and column in the universe (sectors)
+    SectorNeighbors                   neighbors;
+    SectorJumpgates                   jumpgates;
+    SectorLod                         lod;
+    Saveable<SectorTraffic>           traffic;
+    station_ptrs_set_t                stations;
+    Routes const*                     routes;      // the universe's next-hop table (routes.hpp) -- held by its World
+    bool                              isTargeting; // ships may hold targets -- cleared once the sector is uncontested
+    Saveable<ship_ptrs_pset_t> const& ships = _ships;
 
     Sector( pair<size_t, size_t> rowcol, string const& name="", dimensions_t const& size={ 0, 0 } );
     Sector( id_t const& id, pair<size_t, size_t> rowcol, string const& name="", dimensions_t const& size={ 0, 0 } );
+    // Pointers to ships, stations, gates and neighbors still refer to the
+    // original's world (see World::clone)
+    Sector( Sector const& o );
     ~Sector();
 
     void setShips( ship_ptrs_set_t&& ships );
+    void addShip( Ship* ship );
+    void removeShip( Ship* ship );
+    // Re-files a ship in the sector after it docked, undocked or died
+    void updateShip( Ship* ship );
+    // Points every ship entry at the ship's new record after ship storage
+    // moved (see locality.hpp) -- partitions keep their order
+    void relocateShips( std::function<Ship*( Ship* )> const& relocate );
+
+    // Sector ships partitioned by lifecycle state and faction (same
+    // membership as ships) -- unordered, and changed by every add, remove
+    // and update
+    ship_ptrs_t const& stateShips( ShipState state, ShipFaction faction ) const;
+
+    // Factions with live ships in the sector, as factionBit flags
+    unsigned int factionsPresent() const;
+    // Whether any present faction is hostile to another present faction
+    bool isContested() const;
 
 private:
-    ship_ptrs_set_t _ships;
+    Saveable<ship_ptrs_pset_t> _ships;
+    ship_ptrs_t                _partitions[ ShipState_END ][ ShipFaction_END ];
+    unsigned int               _factionsPresent;
+    bool                       _isContested;
+
+    void file( Ship* ship );
+    void unfile( Ship* ship );
+    void updatePresence();
 };
 
 
@@ -237,57 +359,42 @@ struct Weapon : public HasID
     WeaponType type;
     bool isTurret;
     target_ptr_t parent;
-    target_ptr_t target;
+    Saveable<target_ptr_t> target;
     // weaponPosition designates forward mount (0), left (-1), or right (1) -- doesn't apply to turrets
     // these values can be considered 90 degree directional multipliers
     WeaponPosition weaponPosition;
-    float cooldown;
+    Saveable<double> readyAt; // sim time (seconds) the weapon can next fire
     
     Weapon( WeaponType type, bool isTurret, WeaponPosition weaponPosition, HasIDAndSectorAndPosition& parent );
-    Weapon( id_t const& id, WeaponType type, bool isTurret, WeaponPosition weaponPosition, HasIDAndSectorAndPosition& parent, HasIDAndSectorAndPosition* const target, float cooldown );
+    Weapon( id_t const& id, WeaponType type, bool isTurret, WeaponPosition weaponPosition, HasIDAndSectorAndPosition& parent, HasIDAndSectorAndPosition* const target, double readyAt );
     ~Weapon();
 };
 
 
-enum ShipType : unsigned int
-{
-    // ship type in order of priority of target importance, least to greatest,
-    // all civilian ships first
-    ShipType_NONE,
-    ShipType_Courier,
-    ShipType_Transport,
-    ShipType_Scout,
-    ShipType_Corvette,
-    ShipType_Frigate,
-    ShipType_END
-};
-
-
-enum ShipFaction : unsigned int
-{
-    ShipFaction_Neutral,
-    ShipFaction_Player,
-    ShipFaction_Friend,
-    ShipFaction_Foe,
-    ShipFaction_END
-};
-
-
+// Fields a background save reads are Saveable (opt/saveable.hpp, autosave.hpp)
 struct Ship : public HasIDAndSectorAndPosition,
               public HasCode, public HasName,
               public HasDirection, public HasSpeed,
-              public HasDestination
+              public HasDestination, public HasTrajectory
 {
-    ShipType             type;
-    ShipFaction          faction;
-    unsigned int         maxHull, currentHull;
-    weapon_ptrs_t const& weapons = _weapons;
-    weapon_ptrs_t const& turrets = _turrets;
-    target_ptr_t         target;
-    bool                 docked;
-    double               timeout; // used any time the ship needs a delay (docked, dead, etc)
+    Saveable<ShipType>      type;
+    Saveable<ShipFaction>   faction;
+    Saveable<unsigned int>  maxHull, currentHull;
+    Saveable<weapon_ptrs_pvec_t> const& weapons = _weapons;
+    Saveable<weapon_ptrs_pvec_t> const& turrets = _turrets;
+    Saveable<target_ptr_t>  target;
+    Saveable<Sector*>       journey; // final sector of a multi-sector route (nullptr while wandering)
+    Saveable<bool>          docked;
+    bool                    parked;    // record pooled while a dormant sector holds the ship as a count
+    ShipState               state;     // partition the sector has the ship filed under
+    size_t                  stateSlot; // index within that partition
+    Saveable<double>        timeoutAt; // sim time (seconds) the current delay ends (docked, dead, etc)
 
     Ship( Ship&& o );
+    // Weapons are copied too, parented to the copy -- pointers into the world
+    // (sector, destination, targets, journey) still refer to the original's
+    // (see World::clone)
+    Ship( Ship const& o );
     Ship( ShipType type, const unsigned int hull,
         string const& code="", string const& name="",
         Sector* const sector=nullptr, position_t const& position={ 0, 0 },
@@ -299,19 +406,29 @@ struct Ship : public HasIDAndSectorAndPosition,
         Sector* const sector, position_t const& position,
         direction_t const& direction, speed_t const& speed,
         destination_ptr_t destination,
-        HasIDAndSectorAndPosition* target, bool docked, float timeout );
+        HasIDAndSectorAndPosition* target, bool docked, double timeoutAt );
     ~Ship();
 
     void setWeapons( weapon_ptrs_t&& weapons );
     void setTurrets( weapon_ptrs_t&& turrets );
 
+    // Lifecycle state from hull and docking -- state holds the filed one
+    ShipState currentState() const;
+
+    // Position along the current leg at the given sim time (position if not in flight)
+    position_t positionAt( double time ) const;
+    // Store positionAt( time ) in position, keeping the current leg
+    void syncPosition( double time );
+    // End the current leg at its position at the given sim time
+    void stop( double time );
+
     Ship& operator =( Ship&& o );
 
     weapon_ptrs_t weaponsAndTurrets();
 
 private:
-    weapon_ptrs_t _weapons;
-    weapon_ptrs_t _turrets;
+    Saveable<weapon_ptrs_pvec_t> _weapons;
+    Saveable<weapon_ptrs_pvec_t> _turrets;
 };
 bool operator <(const Ship& lhs, const Ship& rhs);
 bool operator ==(const Ship& lhs, const Ship& rhs);
@@ -0,0 +1,189 @@
+// persistent.hpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#ifndef _TINYSPACE_PERSISTENT_HPP_
+#define _TINYSPACE_PERSISTENT_HPP_
+
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+
+namespace tinyspace {
+
+
+// Containers whose copies share structure. Nodes are refcounted and never
+// change while shared: a write copies the nodes on its path that another
+// copy still holds and edits the rest in place. Copying a container is O(1)
+// and the copy is frozen from then on, however the original changes --
+// which is what a snapshot needs (see Saveable in saveable.hpp).
+//
+// Not thread safe for writes. A copy may be read from another thread while
+// the original is written, as long as only the writing thread makes or drops
+// copies of the original.
+
+
+size_t const PERSISTENT_BITS       = 5;                                 // index bits per vector level
+size_t const PERSISTENT_WIDTH      = size_t( 1 ) << PERSISTENT_BITS; // values per leaf, children per branch
+size_t const PERSISTENT_MAX_HEIGHT = 16;                                // set branch levels an iterator can walk
+
+
+template <typename T> struct IsPersistent : std::false_type {};
+
+
+// ---------------------------------------------------------------------------
+// PERSISTENT VECTOR
+// ---------------------------------------------------------------------------
+
+
+// Radix-balanced trie -- index bits pick the child at each level, leaves
+// hold up to PERSISTENT_WIDTH values. Vectors that fit one leaf (weapon
+// lists) are just that leaf.
+template <typename T>
+class PersistentVector
+{
+    struct Node   {};
+    struct Leaf   : Node { std::vector<T> values; };
+    struct Branch : Node { std::vector<std::shared_ptr<Node>> children; };
+
+public:
+    class const_iterator : public std::iterator<std::random_access_iterator_tag, T, std::ptrdiff_t, T const*, T const&>
+    {
+    public:
+        const_iterator();
+        const_iterator( PersistentVector<T> const* vector, size_t index );
+
+        T const& operator *() const;
+        T const* operator ->() const;
+        const_iterator& operator ++();
+        const_iterator  operator ++( int );
+        std::ptrdiff_t  operator -( const_iterator const& o ) const;
+        bool operator ==( const_iterator const& o ) const;
+        bool operator !=( const_iterator const& o ) const;
+
+    private:
+        PersistentVector<T> const* _vector;
+        size_t                     _index;
+        mutable Leaf const*        _leaf;  // holding [ _base, _base + _count )
+        mutable size_t             _base;
+        mutable size_t             _count;
+    };
+
+    PersistentVector();
+    PersistentVector( std::vector<T> const& values );
+    ~PersistentVector();
+
+    size_t size() const;
+    bool   empty() const;
+
+    T const& operator []( size_t index ) const;
+    T const& front() const;
+    T const& back() const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    void push_back( T const& value );
+    void pop_back();
+    void set( size_t index, T const& value );
+    void clear();
+    void reserve( size_t ) {} // nodes are sized as they fill
+
+private:
+    std::shared_ptr<Node> _root;
+    unsigned int          _shift; // index bits below the root -- 0 while the root is a leaf
+    size_t                _size;
+
+    Leaf const* leafAt( size_t index ) const;
+    bool popFrom( std::shared_ptr<Node>& node, unsigned int shift ); // true if node emptied
+
+    static Leaf*   ownLeaf( std::shared_ptr<Node>& node );
+    static Branch* ownBranch( std::shared_ptr<Node>& node );
+};
+template <typename T> struct IsPersistent<PersistentVector<T>> : std::true_type {};
+
+
+// ---------------------------------------------------------------------------
+// PERSISTENT SET
+// ---------------------------------------------------------------------------
+
+
+// B+tree ordered by Compare, so it iterates in the same order std::set
+// would. Branches keep a bound on each child's greatest key to route by.
+// Erasing merges a shrunken node into a neighbor when both fit one node.
+template <typename K, typename Compare=std::less<K>>
+class PersistentSet
+{
+    struct Node   {};
+    struct Leaf   : Node { std::vector<K> keys; };
+    struct Branch : Node { std::vector<K> bounds; std::vector<std::shared_ptr<Node>> children; };
+
+public:
+    class const_iterator : public std::iterator<std::forward_iterator_tag, K, std::ptrdiff_t, K const*, K const&>
+    {
+    public:
+        const_iterator();
+        const_iterator( Node const* root, size_t height );
+
+        K const& operator *() const;
+        K const* operator ->() const;
+        const_iterator& operator ++();
+        const_iterator  operator ++( int );
+        bool operator ==( const_iterator const& o ) const;
+        bool operator !=( const_iterator const& o ) const;
+
+    private:
+        Branch const* _branches[ PERSISTENT_MAX_HEIGHT ]; // root first
+        size_t        _indices[ PERSISTENT_MAX_HEIGHT ];
+        size_t        _height;
+        Leaf const*   _leaf;  // nullptr at the end
+        size_t        _index;
+
+        void descend( Node const* node, size_t level );
+    };
+
+    PersistentSet();
+    template <typename I> PersistentSet( I first, I last );
+    ~PersistentSet();
+
+    size_t size() const;
+    bool   empty() const;
+    size_t count( K const& key ) const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    bool   insert( K const& key ); // false if already present
+    size_t erase( K const& key );
+    void   clear();
+
+private:
+    std::shared_ptr<Node> _root;
+    size_t                _height; // branch levels above the leaves
+    size_t                _size;
+    Compare               _less;
+
+    std::shared_ptr<Node> insertInto( std::shared_ptr<Node>& node, size_t height, K const& key ); // split-off right half, if any
+    bool eraseFrom( std::shared_ptr<Node>& node, size_t height, K const& key ); // true if node emptied
+    void mergeChildren( Branch& branch, size_t index, size_t height );
+
+    static size_t   width( Node const* node, size_t height );
+    static K const& bound( Node const* node, size_t height );
+    static Leaf*    ownLeaf( std::shared_ptr<Node>& node );
+    static Branch*  ownBranch( std::shared_ptr<Node>& node );
+};
+template <typename K, typename C> struct IsPersistent<PersistentSet<K, C>> : std::true_type {};
+
+
+} // tinyspace
+
+
+#include "persistent.tpp"
+
+
+#endif // _TINYSPACE_PERSISTENT_HPP_
@@ -0,0 +1,668 @@
+// persistent.tpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#ifndef _TINYSPACE_PERSISTENT_TPP_
+#define _TINYSPACE_PERSISTENT_TPP_
+
+
+#include <algorithm>
+#include <cassert>
+
+
+namespace tinyspace {
+
+
+// ---------------------------------------------------------------------------
+// PERSISTENT VECTOR
+// ---------------------------------------------------------------------------
+
+
+template <typename T>
+PersistentVector<T>::const_iterator::const_iterator()
+    : _vector( nullptr ), _index( 0 ), _leaf( nullptr ), _base( 0 ), _count( 0 )
+{}
+
+
+template <typename T>
+PersistentVector<T>::const_iterator::const_iterator( PersistentVector<T> const* vector, size_t index )
+    : _vector( vector ), _index( index ), _leaf( nullptr ), _base( 0 ), _count( 0 )
+{}
+
+
+template <typename T>
+T const& PersistentVector<T>::const_iterator::operator *() const
+{
+    if ( _index - _base >= _count ) // wraps below _base
+    {
+        _leaf  = _vector->leafAt( _index );
+        _base  = _index & ~( PERSISTENT_WIDTH - 1 );
+        _count = _leaf->values.size();
+    }
+    return _leaf->values[ _index - _base ];
+}
+
+
+template <typename T>
+T const* PersistentVector<T>::const_iterator::operator ->() const
+{
+    return &**this;
+}
+
+
+template <typename T>
+typename PersistentVector<T>::const_iterator& PersistentVector<T>::const_iterator::operator ++()
+{
+    ++_index;
+    return *this;
+}
+
+
+template <typename T>
+typename PersistentVector<T>::const_iterator PersistentVector<T>::const_iterator::operator ++( int )
+{
+    const_iterator r = *this;
+    ++_index;
+    return r;
+}
+
+
+template <typename T>
+std::ptrdiff_t PersistentVector<T>::const_iterator::operator -( const_iterator const& o ) const
+{
+    return static_cast<std::ptrdiff_t>( _index ) - static_cast<std::ptrdiff_t>( o._index );
+}
+
+
+template <typename T>
+bool PersistentVector<T>::const_iterator::operator ==( const_iterator const& o ) const
+{
+    return _index == o._index;
+}
+
+
+template <typename T>
+bool PersistentVector<T>::const_iterator::operator !=( const_iterator const& o ) const
+{
+    return _index != o._index;
+}
+
+
+template <typename T>
+PersistentVector<T>::PersistentVector()
+    : _root(), _shift( 0 ), _size( 0 )
+{}
+
+
+template <typename T>
+PersistentVector<T>::PersistentVector( std::vector<T> const& values )
+    : PersistentVector()
+{
+    for ( auto& value : values )
+    {
+        push_back( value );
+    }
+}
+
+
+template <typename T>
+PersistentVector<T>::~PersistentVector()
+{}
+
+
+template <typename T>
+size_t PersistentVector<T>::size() const
+{
+    return _size;
+}
+
+
+template <typename T>
+bool PersistentVector<T>::empty() const
+{
+    return ! _size;
+}
+
+
+template <typename T>
+T const& PersistentVector<T>::operator []( size_t index ) const
+{
+    return leafAt( index )->values[ index & ( PERSISTENT_WIDTH - 1 ) ];
+}
+
+
+template <typename T>
+T const& PersistentVector<T>::front() const
+{
+    return ( *this )[ 0 ];
+}
+
+
+template <typename T>
+T const& PersistentVector<T>::back() const
+{
+    return ( *this )[ _size - 1 ];
+}
+
+
+template <typename T>
+typename PersistentVector<T>::const_iterator PersistentVector<T>::begin() const
+{
+    return const_iterator( this, 0 );
+}
+
+
+template <typename T>
+typename PersistentVector<T>::const_iterator PersistentVector<T>::end() const
+{
+    return const_iterator( this, _size );
+}
+
+
+template <typename T>
+void PersistentVector<T>::push_back( T const& value )
+{
+    if ( ! _root )
+    {
+        _root = std::make_shared<Leaf>();
+    }
+    else if ( _size == PERSISTENT_WIDTH << _shift )
+    {
+        // full -- the old root becomes the first child of a new one
+        auto root = std::make_shared<Branch>();
+        root->children.push_back( std::move( _root ));
+        _root   = std::move( root );
+        _shift += PERSISTENT_BITS;
+    }
+
+    std::shared_ptr<Node>* node = &_root;
+    for ( unsigned int shift = _shift; shift; shift -= PERSISTENT_BITS )
+    {
+        Branch* branch = ownBranch( *node );
+        size_t  child  = ( _size >> shift ) & ( PERSISTENT_WIDTH - 1 );
+        if ( child == branch->children.size() )
+        {
+            if ( shift == PERSISTENT_BITS ) branch->children.push_back( std::make_shared<Leaf>() );
+            else                            branch->children.push_back( std::make_shared<Branch>() );
+        }
+        node = &branch->children[ child ];
+    }
+    ownLeaf( *node )->values.push_back( value );
+    ++_size;
+}
+
+
+template <typename T>
+void PersistentVector<T>::pop_back()
+{
+    if ( popFrom( _root, _shift ))
+    {
+        _root.reset();
+        _shift = 0;
+    }
+    --_size;
+
+    // a root with one child is just that child
+    while ( _shift && static_cast<Branch const*>( _root.get() )->children.size() == 1 )
+    {
+        std::shared_ptr<Node> child = static_cast<Branch const*>( _root.get() )->children[ 0 ];
+        _root   = std::move( child );
+        _shift -= PERSISTENT_BITS;
+    }
+}
+
+
+template <typename T>
+void PersistentVector<T>::set( size_t index, T const& value )
+{
+    std::shared_ptr<Node>* node = &_root;
+    for ( unsigned int shift = _shift; shift; shift -= PERSISTENT_BITS )
+    {
+        node = &ownBranch( *node )->children[ ( index >> shift ) & ( PERSISTENT_WIDTH - 1 ) ];
+    }
+    ownLeaf( *node )->values[ index & ( PERSISTENT_WIDTH - 1 ) ] = value;
+}
+
+
+template <typename T>
+void PersistentVector<T>::clear()
+{
+    _root.reset();
+    _shift = 0;
+    _size  = 0;
+}
+
+
+template <typename T>
+typename PersistentVector<T>::Leaf const* PersistentVector<T>::leafAt( size_t index ) const
+{
+    Node const* node = _root.get();
+    for ( unsigned int shift = _shift; shift; shift -= PERSISTENT_BITS )
+    {
+        node = static_cast<Branch const*>( node )->children[ ( index >> shift ) & ( PERSISTENT_WIDTH - 1 ) ].get();
+    }
+    return static_cast<Leaf const*>( node );
+}
+
+
+template <typename T>
+bool PersistentVector<T>::popFrom( std::shared_ptr<Node>& node, unsigned int shift )
+{
+    if ( ! shift )
+    {
+        Leaf* leaf = ownLeaf( node );
+        leaf->values.pop_back();
+        return leaf->values.empty();
+    }
+    Branch* branch = ownBranch( node );
+    if ( popFrom( branch->children.back(), shift - PERSISTENT_BITS ))
+    {
+        branch->children.pop_back();
+    }
+    return branch->children.empty();
+}
+
+
+template <typename T>
+typename PersistentVector<T>::Leaf* PersistentVector<T>::ownLeaf( std::shared_ptr<Node>& node )
+{
+    if ( node.use_count() != 1 )
+    {
+        node = std::make_shared<Leaf>( *static_cast<Leaf const*>( node.get() ));
+    }
+    return static_cast<Leaf*>( node.get() );
+}
+
+
+template <typename T>
+typename PersistentVector<T>::Branch* PersistentVector<T>::ownBranch( std::shared_ptr<Node>& node )
+{
+    if ( node.use_count() != 1 )
+    {
+        node = std::make_shared<Branch>( *static_cast<Branch const*>( node.get() ));
+    }
+    return static_cast<Branch*>( node.get() );
+}
+
+
+// ---------------------------------------------------------------------------
+// PERSISTENT SET
+// ---------------------------------------------------------------------------
+
+
+template <typename K, typename Compare>
+PersistentSet<K, Compare>::const_iterator::const_iterator()
+    : _height( 0 ), _leaf( nullptr ), _index( 0 )
+{}
+
+
+template <typename K, typename Compare>
+PersistentSet<K, Compare>::const_iterator::const_iterator( Node const* root, size_t height )
+    : _height( height ), _leaf( nullptr ), _index( 0 )
+{
+    if ( root )
+    {
+        descend( root, 0 );
+    }
+}
+
+
+template <typename K, typename Compare>
+K const& PersistentSet<K, Compare>::const_iterator::operator *() const
+{
+    return _leaf->keys[ _index ];
+}
+
+
+template <typename K, typename Compare>
+K const* PersistentSet<K, Compare>::const_iterator::operator ->() const
+{
+    return &_leaf->keys[ _index ];
+}
+
+
+template <typename K, typename Compare>
+typename PersistentSet<K, Compare>::const_iterator& PersistentSet<K, Compare>::const_iterator::operator ++()
+{
+    if ( ++_index < _leaf->keys.size() )
+    {
+        return *this;
+    }
+    // climb to the nearest branch with a next child, then down its left edge
+    for ( size_t level = _height; level--; )
+    {
+        Branch const* branch = _branches[ level ];
+        if ( ++_indices[ level ] < branch->children.size() )
+        {
+            descend( branch->children[ _indices[ level ]].get(), level + 1 );
+            return *this;
+        }
+    }
+    _leaf  = nullptr;
+    _index = 0;
+    return *this;
+}
+
+
+template <typename K, typename Compare>
+typename PersistentSet<K, Compare>::const_iterator PersistentSet<K, Compare>::const_iterator::operator ++( int )
+{
+    const_iterator r = *this;
+    ++*this;
+    return r;
+}
+
+
+template <typename K, typename Compare>
+bool PersistentSet<K, Compare>::const_iterator::operator ==( const_iterator const& o ) const
+{
+    return _leaf == o._leaf && _index == o._index;
+}
+
+
+template <typename K, typename Compare>
+bool PersistentSet<K, Compare>::const_iterator::operator !=( const_iterator const& o ) const
+{
+    return ! ( *this == o );
+}
+
+
+template <typename K, typename Compare>
+void PersistentSet<K, Compare>::const_iterator::descend( Node const* node, size_t level )
+{
+    for ( ; level < _height; ++level )
+    {
+        Branch const* branch = static_cast<Branch const*>( node );
+        _branches[ level ] = branch;
+        _indices[ level ]  = 0;
+        node = branch->children[ 0 ].get();
+    }
+    _leaf  = static_cast<Leaf const*>( node );
+    _index = 0;
+}
+
+
+template <typename K, typename Compare>
+PersistentSet<K, Compare>::PersistentSet()
+    : _root(), _height( 0 ), _size( 0 ), _less()
+{}
+
+
+template <typename K, typename Compare>
+template <typename I>
+PersistentSet<K, Compare>::PersistentSet( I first, I last )
+    : PersistentSet()
+{
+    for ( ; first != last; ++first )
+    {
+        insert( *first );
+    }
+}
+
+
+template <typename K, typename Compare>
+PersistentSet<K, Compare>::~PersistentSet()
+{}
+
+
+template <typename K, typename Compare>
+size_t PersistentSet<K, Compare>::size() const
+{
+    return _size;
+}
+
+
+template <typename K, typename Compare>
+bool PersistentSet<K, Compare>::empty() const
+{
+    return ! _size;
+}
+
+
+template <typename K, typename Compare>
+size_t PersistentSet<K, Compare>::count( K const& key ) const
+{
+    Node const* node = _root.get();
+    if ( ! node )
+    {
+        return 0;
+    }
+    for ( size_t height = _height; height; --height )
+    {
+        Branch const* branch = static_cast<Branch const*>( node );
+        auto it = std::lower_bound( branch->bounds.begin(), branch->bounds.end(), key, _less );
+        if ( it == branch->bounds.end() )
+        {
+            return 0;
+        }
+        node = branch->children[ it - branch->bounds.begin() ].get();
+    }
+    Leaf const* leaf = static_cast<Leaf const*>( node );
+    auto it = std::lower_bound( leaf->keys.begin(), leaf->keys.end(), key, _less );
+    return it != leaf->keys.end() && ! _less( key, *it );
+}
+
+
+template <typename K, typename Compare>
+typename PersistentSet<K, Compare>::const_iterator PersistentSet<K, Compare>::begin() const
+{
+    return const_iterator( _root.get(), _height );
+}
+
+
+template <typename K, typename Compare>
+typename PersistentSet<K, Compare>::const_iterator PersistentSet<K, Compare>::end() const
+{
+    return const_iterator();
+}
+
+
+template <typename K, typename Compare>
+bool PersistentSet<K, Compare>::insert( K const& key )
+{
+    // checked first, so a present key copies no nodes
+    if ( count( key ))
+    {
+        return false;
+    }
+    if ( ! _root )
+    {
+        _root = std::make_shared<Leaf>();
+    }
+    std::shared_ptr<Node> right = insertInto( _root, _height, key );
+    if ( right )
+    {
+        auto root = std::make_shared<Branch>();
+        root->bounds.push_back( bound( _root.get(), _height ));
+        root->bounds.push_back( bound( right.get(), _height ));
+        root->children.push_back( std::move( _root ));
+        root->children.push_back( std::move( right ));
+        _root = std::move( root );
+        ++_height;
+        assert( _height < PERSISTENT_MAX_HEIGHT );
+    }
+    ++_size;
+    return true;
+}
+
+
+template <typename K, typename Compare>
+size_t PersistentSet<K, Compare>::erase( K const& key )
+{
+    if ( ! count( key ))
+    {
+        return 0;
+    }
+    if ( eraseFrom( _root, _height, key ))
+    {
+        _root.reset();
+        _height = 0;
+    }
+    // a root with one child is just that child
+    while ( _height && width( _root.get(), _height ) == 1 )
+    {
+        std::shared_ptr<Node> child = static_cast<Branch const*>( _root.get() )->children[ 0 ];
+        _root = std::move( child );
+        --_height;
+    }
+    --_size;
+    return 1;
+}
+
+
+template <typename K, typename Compare>
+void PersistentSet<K, Compare>::clear()
+{
+    _root.reset();
+    _height = 0;
+    _size   = 0;
+}
+
+
+template <typename K, typename Compare>
+std::shared_ptr<typename PersistentSet<K, Compare>::Node> PersistentSet<K, Compare>::insertInto(
+    std::shared_ptr<Node>& node, size_t height, K const& key )
+{
+    if ( ! height )
+    {
+        Leaf* leaf = ownLeaf( node );
+        leaf->keys.insert( std::lower_bound( leaf->keys.begin(), leaf->keys.end(), key, _less ), key );
+        if ( leaf->keys.size() <= PERSISTENT_WIDTH )
+        {
+            return nullptr;
+        }
+        auto right = std::make_shared<Leaf>();
+        size_t half = leaf->keys.size() / 2;
+        right->keys.assign( leaf->keys.begin() + half, leaf->keys.end() );
+        leaf->keys.resize( half );
+        return right;
+    }
+
+    Branch* branch = ownBranch( node );
+    size_t  index  = std::lower_bound( branch->bounds.begin(), branch->bounds.end(), key, _less ) - branch->bounds.begin();
+    if ( index == branch->bounds.size() )
+    {
+        branch->bounds[ --index ] = key; // past every bound -- the last child grows to take it
+    }
+    std::shared_ptr<Node> split = insertInto( branch->children[ index ], height - 1, key );
+    if ( split )
+    {
+        K rightBound = branch->bounds[ index ];
+        branch->bounds[ index ] = bound( branch->children[ index ].get(), height - 1 );
+        branch->bounds.insert( branch->bounds.begin() + index + 1, rightBound );
+        branch->children.insert( branch->children.begin() + index + 1, std::move( split ));
+    }
+    if ( branch->children.size() <= PERSISTENT_WIDTH )
+    {
+        return nullptr;
+    }
+    auto right = std::make_shared<Branch>();
+    size_t half = branch->children.size() / 2;
+    right->bounds.assign( branch->bounds.begin() + half, branch->bounds.end() );
+    right->children.assign( branch->children.begin() + half, branch->children.end() );
+    branch->bounds.resize( half );
+    branch->children.resize( half );
+    return right;
+}
+
+
+template <typename K, typename Compare>
+bool PersistentSet<K, Compare>::eraseFrom( std::shared_ptr<Node>& node, size_t height, K const& key )
+{
+    if ( ! height )
+    {
+        Leaf* leaf = ownLeaf( node );
+        leaf->keys.erase( std::lower_bound( leaf->keys.begin(), leaf->keys.end(), key, _less ));
+        return leaf->keys.empty();
+    }
+
+    Branch* branch = ownBranch( node );
+    size_t  index  = std::lower_bound( branch->bounds.begin(), branch->bounds.end(), key, _less ) - branch->bounds.begin();
+    if ( eraseFrom( branch->children[ index ], height - 1, key ))
+    {
+        branch->bounds.erase( branch->bounds.begin() + index );
+        branch->children.erase( branch->children.begin() + index );
+    }
+    else
+    {
+        mergeChildren( *branch, index, height - 1 );
+    }
+    return branch->children.empty();
+}
+
+
+template <typename K, typename Compare>
+void PersistentSet<K, Compare>::mergeChildren( Branch& branch, size_t index, size_t height )
+{
+    if ( branch.children.size() < 2 || width( branch.children[ index ].get(), height ) >= PERSISTENT_WIDTH / 4 )
+    {
+        return;
+    }
+    size_t left  = index + 1 < branch.children.size() ? index : index - 1;
+    size_t right = left + 1;
+    if ( width( branch.children[ left ].get(), height ) + width( branch.children[ right ].get(), height ) > PERSISTENT_WIDTH )
+    {
+        return;
+    }
+
+    if ( ! height )
+    {
+        Leaf*       into = ownLeaf( branch.children[ left ] );
+        Leaf const* from = static_cast<Leaf const*>( branch.children[ right ].get() );
+        into->keys.insert( into->keys.end(), from->keys.begin(), from->keys.end() );
+    }
+    else
+    {
+        Branch*       into = ownBranch( branch.children[ left ] );
+        Branch const* from = static_cast<Branch const*>( branch.children[ right ].get() );
+        into->bounds.insert( into->bounds.end(), from->bounds.begin(), from->bounds.end() );
+        into->children.insert( into->children.end(), from->children.begin(), from->children.end() );
+    }
+    branch.bounds[ left ] = branch.bounds[ right ];
+    branch.bounds.erase( branch.bounds.begin() + right );
+    branch.children.erase( branch.children.begin() + right );
+}
+
+
+template <typename K, typename Compare>
+size_t PersistentSet<K, Compare>::width( Node const* node, size_t height )
+{
+    return height ? static_cast<Branch const*>( node )->children.size()
+                  : static_cast<Leaf const*>( node )->keys.size();
+}
+
+
+template <typename K, typename Compare>
+K const& PersistentSet<K, Compare>::bound( Node const* node, size_t height )
+{
+    return height ? static_cast<Branch const*>( node )->bounds.back()
+                  : static_cast<Leaf const*>( node )->keys.back();
+}
+
+
+template <typename K, typename Compare>
+typename PersistentSet<K, Compare>::Leaf* PersistentSet<K, Compare>::ownLeaf( std::shared_ptr<Node>& node )
+{
+    if ( node.use_count() != 1 )
+    {
+        node = std::make_shared<Leaf>( *static_cast<Leaf const*>( node.get() ));
+    }
+    return static_cast<Leaf*>( node.get() );
+}
+
+
+template <typename K, typename Compare>
+typename PersistentSet<K, Compare>::Branch* PersistentSet<K, Compare>::ownBranch( std::shared_ptr<Node>& node )
+{
+    if ( node.use_count() != 1 )
+    {
+        node = std::make_shared<Branch>( *static_cast<Branch const*>( node.get() ));
+    }
+    return static_cast<Branch*>( node.get() );
+}
+
+
+} // tinyspace
+
+
+#endif // _TINYSPACE_PERSISTENT_TPP_
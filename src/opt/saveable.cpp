@@ -4,51 +4,176 @@
 
 #include "saveable.hpp"
 
+#include <cassert>
+#include <thread>
+
 
 namespace tinyspace {
 
 
-std::atomic<bool> isSaving( false );
-std::atomic<std::thread*> saveThread( nullptr );
+std::atomic<bool>     isSaving( false );
+std::atomic<uint32_t> saveEpoch( 1 );
+std::atomic<unsigned> snapshotReaders( 0 );
+__thread uint32_t     readEpoch = 0;
+__thread bool         detachedWrites = false;
+
+
+static_assert( sizeof( Saveable<float> ) <= 12, "Saveable<float> should hold both slots inline" );
+static_assert( std::is_trivially_copyable<Vector2<float>>::value, "Vector2<float> should take the inline Saveable" );
+
+
+void beginSnapshot()
+{
+    // the epoch goes first, so a reader that sees the snapshot open reads it
+    saveEpoch = saveEpoch % 0x7FFFFFFF + 1; // 31 bits fit a Saveable's state word -- 0 is never
+    isSaving  = true;
+}
 
 
-bool isSavingThread()
+size_t endSnapshot()
 {
-    if ( ! isSaving )
+    // a reader counts itself before checking isSaving, so once this is
+    // closed any reader still counted got in first -- wait it out
+    isSaving = false;
+    while ( snapshotReaders.load() )
     {
-        return false;
+        std::this_thread::yield();
     }
-    std::thread* saveThreadPtr = saveThread.load();
-    if ( ! saveThreadPtr)
+    return update_aftersave();
+}
+
+
+SnapshotReader::SnapshotReader()
+    : isOpen( ( ++snapshotReaders, isSaving.load() )), _previous( readEpoch )
+{
+    if ( ! isOpen )
     {
-        return false;
+        --snapshotReaders;
+        return;
     }
-    return saveThreadPtr->get_id() == std::this_thread::get_id();
+    readEpoch = saveEpoch.load();
 }
 
-namespace {
-    std::unordered_set<Updateable*> updateables_aftersave;
+
+SnapshotReader::~SnapshotReader()
+{
+    if ( isOpen )
+    {
+        readEpoch = _previous;
+        snapshotReaders.fetch_sub( 1, std::memory_order_release );
+    }
 }
 
 
-Updateable::Updateable()
+DetachedWrites::DetachedWrites()
+    : _previous( detachedWrites )
+{
+    detachedWrites = true;
+}
+
+
+DetachedWrites::~DetachedWrites()
 {
-    updateables_aftersave.insert( this );
+    detachedWrites = _previous;
 }
 
 
+// ---------------------------------------------------------------------------
+// DIRTY LIST
+// ---------------------------------------------------------------------------
+
+
+namespace {
+
+// Slots are claimed with a single fetch_add and live in fixed-size chunks
+// that are installed on first use and kept for later saves, so filing an
+// object never locks and never moves another object's slot
+size_t const DIRTY_CHUNK_SIZE  = 4096;
+size_t const DIRTY_CHUNK_COUNT = 4096; // room for 16M objects diverging in one save
+
+struct DirtyChunk
+{
+    std::atomic<Updateable*> slots[ DIRTY_CHUNK_SIZE ];
+};
+
+std::atomic<size_t>      dirtyCount( 0 );
+std::atomic<DirtyChunk*> dirtyChunks[ DIRTY_CHUNK_COUNT ];
+
+} // anonymous
+
+
+Updateable::Updateable()
+    : _dirtySlot( nullptr )
+{}
+
+
+Updateable::Updateable( Updateable const& )
+    : _dirtySlot( nullptr )
+{}
+
+
 Updateable::~Updateable()
 {
-    updateables_aftersave.erase( this );
+    if ( _dirtySlot )
+    {
+        _dirtySlot->store( nullptr, std::memory_order_relaxed );
+    }
+}
+
+
+Updateable& Updateable::operator =( Updateable const& )
+{
+    return *this; // dirtiness belongs to the object, not its value
+}
+
+
+bool Updateable::isDirty() const
+{
+    return _dirtySlot;
+}
+
+
+void Updateable::markDirty()
+{
+    size_t index = dirtyCount.fetch_add( 1, std::memory_order_relaxed );
+    assert( index / DIRTY_CHUNK_SIZE < DIRTY_CHUNK_COUNT );
+    auto&  entry = dirtyChunks[ index / DIRTY_CHUNK_SIZE ];
+
+    DirtyChunk* chunk = entry.load( std::memory_order_acquire );
+    if ( ! chunk )
+    {
+        DirtyChunk* fresh = new DirtyChunk();
+        if ( entry.compare_exchange_strong( chunk, fresh, std::memory_order_acq_rel ))
+        {
+            chunk = fresh;
+        }
+        else
+        {
+            delete fresh; // another thread installed it first
+        }
+    }
+    _dirtySlot = &chunk->slots[ index % DIRTY_CHUNK_SIZE ];
+    _dirtySlot->store( this, std::memory_order_relaxed );
 }
 
 
-void update_aftersave()
+size_t update_aftersave()
 {
-    for (auto u : updateables_aftersave)
+    size_t count      = dirtyCount.load( std::memory_order_acquire );
+    size_t reconciled = 0;
+    for ( size_t i = 0; i < count; ++i )
     {
-        u->update();
+        auto& slot = dirtyChunks[ i / DIRTY_CHUNK_SIZE ].load( std::memory_order_relaxed )->slots[ i % DIRTY_CHUNK_SIZE ];
+        if ( Updateable* u = slot.load( std::memory_order_relaxed ))
+        {
+            slot.store( nullptr, std::memory_order_relaxed );
+            u->_dirtySlot = nullptr;
+            u->update();
+            ++reconciled;
+        }
     }
+    dirtyCount.store( 0, std::memory_order_release );
+    return reconciled;
 }
 
 
@@ -7,9 +7,11 @@
 
 
 #include <atomic>
+#include <cstdint>
 #include <ostream>
 #include <memory>
-#include <thread>
+#include <type_traits>
+#include "persistent.hpp"
 #include "vector2.hpp"
 
 
@@ -21,12 +23,30 @@ namespace tinyspace {
 // ---------------------------------------------------------------------------
 
 
+// Objects aren't registered up front. The first write that makes one
+// diverge from its snapshot during a save files it on a lock-free dirty
+// list, and update_aftersave reconciles just those -- construction costs
+// nothing, and reconciling costs the objects that changed.
 struct Updateable {
     Updateable();
+    Updateable( Updateable const& o );
     virtual ~Updateable();
     virtual void update() = 0;
+
+    Updateable& operator =( Updateable const& o );
+
+protected:
+    bool isDirty() const;
+    void markDirty(); // safe from any thread; once per save
+
+private:
+    std::atomic<Updateable*>* _dirtySlot; // entry on the dirty list, while on it
+
+    friend size_t update_aftersave();
 };
-void update_aftersave();
+// Reconciles the objects that diverged during the save that just ended --
+// call with the save thread joined and no writers running. Returns how many.
+size_t update_aftersave();
 
 
 // ---------------------------------------------------------------------------
@@ -34,21 +54,74 @@ void update_aftersave();
 // ---------------------------------------------------------------------------
 
 
-extern std::atomic<bool> isSaving;
-extern std::atomic<std::thread*> saveThread;
+extern std::atomic<bool>     isSaving;        // a snapshot is open -- first writes set values aside
+extern std::atomic<uint32_t> saveEpoch;       // bumped as each snapshot opens -- never 0
+extern std::atomic<unsigned> snapshotReaders; // threads holding a SnapshotReader
+extern __thread uint32_t     readEpoch;       // snapshot this thread reads -- 0 reads live
+                                              // (__thread, as an extern thread_local read calls an init guard)
+extern __thread bool         detachedWrites;  // writes on this thread set nothing aside (DetachedWrites)
 
 
-bool isSavingThread();
+// Whether a write on this thread must set the value it replaces aside
+inline bool setsAside()
+{
+    return ! detachedWrites && isSaving.load( std::memory_order_relaxed );
+}
 
 
-template <typename T>
+// Opens a snapshot of every Saveable as it stands -- call between ticks,
+// with no writers running
+void beginSnapshot();
+
+// Closes the open snapshot once its readers have let go, and reconciles the
+// objects that diverged while it was open. Returns how many.
+size_t endSnapshot();
+
+
+// Reads on the constructing thread resolve to the open snapshot until the
+// reader is destroyed. Any number of threads may read one snapshot at once.
+// Decided once here, so each field read costs a thread-local load rather
+// than a check of which thread is asking.
+struct SnapshotReader
+{
+    bool const isOpen; // false if no snapshot was open -- reads stay live
+
+    SnapshotReader();
+    ~SnapshotReader();
+
+    SnapshotReader( SnapshotReader const& ) = delete;
+    SnapshotReader& operator =( SnapshotReader const& ) = delete;
+
+private:
+    uint32_t _previous;
+};
+
+
+// Writes on the constructing thread set nothing aside until it's destroyed,
+// snapshot open or not -- for objects no snapshot covers, like a world
+// cloned for a what-if run (world.hpp), which may step on another thread
+// while the original saves
+struct DetachedWrites
+{
+    DetachedWrites();
+    ~DetachedWrites();
+
+    DetachedWrites( DetachedWrites const& ) = delete;
+    DetachedWrites& operator =( DetachedWrites const& ) = delete;
+
+private:
+    bool _previous;
+};
+
+
+template <typename T, typename Enable=void>
 class Saveable : public Updateable
 {
 public:
     Saveable();
     Saveable( T const& t );
     Saveable( T&& t );
-    Saveable( Saveable<T> const& o );
+    Saveable( Saveable<T, Enable> const& o );
 
     ~Saveable();
 
@@ -56,11 +129,74 @@ public:
     void set( T&& t );
     void update() override;
 
+    // Live value for in-place modification (containers, aggregates) --
+    // copied off the snapshot first while saving
+    T& edit();
+
     T const& live();
     T const& snap();
 
+    Saveable<T, Enable>& operator =( T const& t );
+    Saveable<T, Enable>& operator =( T&& t );
+    Saveable<T, Enable>& operator =( Saveable<T, Enable> const& o );
+
+    Saveable<T, Enable>& operator *=( T const& t );
+    Saveable<T, Enable>& operator /=( T const& t );
+    Saveable<T, Enable>& operator +=( T const& t );
+    Saveable<T, Enable>& operator -=( T const& t );
+
+    operator T const&() const;
+    T const& operator ()() const;
+    T const* operator ->() const;
+
+private:
+    T *_live, *_snap;
+};
+template <typename T> std::ostream& operator <<( std::ostream& os, Saveable<T> const& o );
+
+
+// ---------------------------------------------------------------------------
+// INLINE DOUBLE BUFFER FOR TRIVIALLY COPYABLE TYPES
+// ---------------------------------------------------------------------------
+
+
+// Live and snapshot values side by side, plus a state word holding which
+// slot is live and the save epoch the slots last diverged in. The first
+// write after a save begins switches to the other slot, leaving the old one
+// as the snapshot. Reads during a later save see an older epoch and take
+// the live slot, so nothing is allocated, registered, or reconciled.
+template <typename T>
+class SaveableSlots
+{
+public:
+    SaveableSlots( T const& t );
+    SaveableSlots( SaveableSlots<T> const& o );
+
+    void set( T const& t );
+    T& edit();
+
+    T const& live() const;
+    T const& snap() const; // as the current save began
+
+protected:
+    T const& get() const; // snap on a SnapshotReader's thread, live elsewhere
+
+private:
+    T                     _slots[ 2 ];
+    std::atomic<uint32_t> _state; // epoch << 1 | live slot
+};
+
+
+template <typename T>
+class Saveable<T, typename std::enable_if<std::is_trivially_copyable<T>::value && ! std::is_pointer<T>::value>::type>
+    : public SaveableSlots<T>
+{
+public:
+    Saveable();
+    Saveable( T const& t );
+    Saveable( Saveable<T> const& o );
+
     Saveable<T>& operator =( T const& t );
-    Saveable<T>& operator =( T&& t );
     Saveable<T>& operator =( Saveable<T> const& o );
 
     Saveable<T>& operator *=( T const& t );
@@ -71,39 +207,24 @@ public:
     operator T const&() const;
     T const& operator ()() const;
     T const* operator ->() const;
-
-private:
-    T *_live, *_snap;
 };
-template <typename T> std::ostream& operator <<( std::ostream& os, Saveable<T> const& o );
 
 
 // Raw pointer specialization
 template <typename T>
-class Saveable<T*> : public Updateable
+class Saveable<T*> : public SaveableSlots<T*>
 {
 public:
     Saveable();
     Saveable( T* const& t );
     Saveable( Saveable<T*> const& o );
 
-    ~Saveable();
-
-    void set( T* const& t );
-    void update() override;
-
-    T* const& live();
-    T* const& snap();
-
     Saveable<T*>& operator =( T* const& t );
     Saveable<T*>& operator =( Saveable<T*> const& o );
 
     operator T* const&() const;
     T* const& operator ()() const;
-    T* const operator ->() const;
-
-private:
-    T *_live, *_snap;
+    T* operator ->() const;
 };
 
 
@@ -137,6 +258,46 @@ private:
 };
 
 
+// Persistent container specialization (persistent.hpp) -- two copies and a
+// state word, as SaveableSlots. The first write during a save copies the
+// live one into the other slot, which is O(1) as they share every node, and
+// switches to it: the old copy holds still for the save while writes copy
+// only the nodes on their path. Once the save is over the old copy is
+// dropped, so writes go back to editing nodes in place.
+template <typename T>
+class Saveable<T, typename std::enable_if<IsPersistent<T>::value>::type> : public Updateable
+{
+public:
+    Saveable();
+    Saveable( T const& t );
+    Saveable( T&& t );
+    Saveable( Saveable<T> const& o );
+
+    void set( T const& t );
+    void set( T&& t );
+    void update() override;
+
+    T& edit();
+
+    T const& live() const;
+    T const& snap() const; // as the current save began
+
+    Saveable<T>& operator =( T const& t );
+    Saveable<T>& operator =( T&& t );
+    Saveable<T>& operator =( Saveable<T> const& o );
+
+    operator T const&() const;
+    T const& operator ()() const;
+    T const* operator ->() const;
+
+private:
+    T                     _slots[ 2 ];
+    std::atomic<uint32_t> _state; // epoch << 1 | live slot
+
+    T const& get() const;
+};
+
+
 // Specialized Vector2 wrapper
 template <typename T, typename U=float>
 struct SaveableVector2 : public Vector2<Saveable<T>, U>
@@ -148,6 +309,8 @@ struct SaveableVector2 : public Vector2<Saveable<T>, U>
 
     ~SaveableVector2();
 
+    SaveableVector2<T,U>& operator =( Vector2<T,U> const& o );
+
     operator Vector2<T,U>() const;
     Vector2<T,U> operator ()() const;
 };
@@ -6,46 +6,43 @@
 #define _TINYSPACE_SAVEABLE_TPP_
 
 
-#include <unordered_set>
-
-
 namespace tinyspace {
 
 
-template <typename T>
-Saveable<T>::Saveable()
+template <typename T, typename Enable>
+Saveable<T, Enable>::Saveable()
     : Updateable()
 {
-    _snap = _live = new T;
+    _snap = _live = new T();
 }
 
 
-template <typename T>
-Saveable<T>::Saveable( T const& t )
+template <typename T, typename Enable>
+Saveable<T, Enable>::Saveable( T const& t )
     : Updateable()
 {
     _snap = _live = new T( t );
 }
 
 
-template <typename T>
-Saveable<T>::Saveable( T&& t )
+template <typename T, typename Enable>
+Saveable<T, Enable>::Saveable( T&& t )
     : Updateable()
 {
     _snap = _live = new T( t );
 }
 
 
-template <typename T>
-Saveable<T>::Saveable( Saveable<T> const& o )
+template <typename T, typename Enable>
+Saveable<T, Enable>::Saveable( Saveable<T, Enable> const& o )
     : Updateable()
 {
     _snap = _live = new T( *o._live );
 }
 
 
-template <typename T>
-Saveable<T>::~Saveable()
+template <typename T, typename Enable>
+Saveable<T, Enable>::~Saveable()
 {
     if (_snap != _live)
     {
@@ -55,12 +52,13 @@ Saveable<T>::~Saveable()
 }
 
 
-template <typename T>
-void Saveable<T>::set( T const& t )
+template <typename T, typename Enable>
+void Saveable<T, Enable>::set( T const& t )
 {
-    if (isSaving && _live == _snap)
+    if (setsAside() && _live == _snap)
     {
         _live = new T(t);
+        markDirty();
     }
     else
     {
@@ -69,12 +67,13 @@ void Saveable<T>::set( T const& t )
 }
 
 
-template <typename T>
-void Saveable<T>::set( T&& t )
+template <typename T, typename Enable>
+void Saveable<T, Enable>::set( T&& t )
 {
-    if (isSaving && _live == _snap)
+    if (setsAside() && _live == _snap)
     {
         _live = new T(t);
+        markDirty();
     }
     else
     {
@@ -83,8 +82,8 @@ void Saveable<T>::set( T&& t )
 }
 
 
-template <typename T>
-void Saveable<T>::update()
+template <typename T, typename Enable>
+void Saveable<T, Enable>::update()
 {
     if (_snap != _live)
     {
@@ -94,94 +93,106 @@ void Saveable<T>::update()
 }
 
 
-template <typename T>
-T const& Saveable<T>::live()
+template <typename T, typename Enable>
+T& Saveable<T, Enable>::edit()
 {
+    if (setsAside() && _live == _snap)
+    {
+        _live = new T(*_snap);
+        markDirty();
+    }
     return *_live;
 }
 
 
-template <typename T>
-T const& Saveable<T>::snap()
+template <typename T, typename Enable>
+T const& Saveable<T, Enable>::live()
+{
+    return *_live;
+}
+
+
+template <typename T, typename Enable>
+T const& Saveable<T, Enable>::snap()
 {
     return *_snap;
 }
 
 
-template <typename T>
-Saveable<T>& Saveable<T>::operator =( T const& t )
+template <typename T, typename Enable>
+Saveable<T, Enable>& Saveable<T, Enable>::operator =( T const& t )
 {
     set( t );
     return *this;
 }
 
 
-template <typename T>
-Saveable<T>& Saveable<T>::operator =( T&& t )
+template <typename T, typename Enable>
+Saveable<T, Enable>& Saveable<T, Enable>::operator =( T&& t )
 {
     set( t );
     return *this;
 }
 
 
-template <typename T>
-Saveable<T>& Saveable<T>::operator =( Saveable<T> const& o )
+template <typename T, typename Enable>
+Saveable<T, Enable>& Saveable<T, Enable>::operator =( Saveable<T, Enable> const& o )
 {
     set( *o._live );
     return *this;
 }
 
 
-template <typename T>
-Saveable<T>& Saveable<T>::operator *=( T const& t )
+template <typename T, typename Enable>
+Saveable<T, Enable>& Saveable<T, Enable>::operator *=( T const& t )
 {
     set( *_live * t );
     return *this;
 }
 
 
-template <typename T>
-Saveable<T>& Saveable<T>::operator /=( T const& t )
+template <typename T, typename Enable>
+Saveable<T, Enable>& Saveable<T, Enable>::operator /=( T const& t )
 {
     set( *_live / t );
     return *this;
 }
 
 
-template <typename T>
-Saveable<T>& Saveable<T>::operator +=( T const& t )
+template <typename T, typename Enable>
+Saveable<T, Enable>& Saveable<T, Enable>::operator +=( T const& t )
 {
     set( *_live + t );
     return *this;
 }
 
 
-template <typename T>
-Saveable<T>& Saveable<T>::operator -=( T const& t )
+template <typename T, typename Enable>
+Saveable<T, Enable>& Saveable<T, Enable>::operator -=( T const& t )
 {
     set( *_live - t );
     return *this;
 }
 
 
-template <typename T>
-Saveable<T>::operator T const&() const
+template <typename T, typename Enable>
+Saveable<T, Enable>::operator T const&() const
 {
-    return isSavingThread() ? *_snap : *_live;
+    return readEpoch ? *_snap : *_live;
 }
 
 
-template <typename T>
-T const& Saveable<T>::operator ()() const
+template <typename T, typename Enable>
+T const& Saveable<T, Enable>::operator ()() const
 {
-    return isSavingThread() ? *_snap : *_live;
+    return readEpoch ? *_snap : *_live;
 }
 
 
-template <typename T>
-T const* Saveable<T>::operator ->() const
+template <typename T, typename Enable>
+T const* Saveable<T, Enable>::operator ->() const
 {
-    return isSavingThread() ? _snap : _live;
+    return readEpoch ? _snap : _live;
 }
 
 
@@ -193,106 +204,231 @@ std::ostream& operator <<( std::ostream& os, Saveable<T> const& o )
 }
 
 
-//----------------------------------------------------------------------------
-// RAW POINTER SPECIALIZATION
-//----------------------------------------------------------------------------
+// ---------------------------------------------------------------------------
+// INLINE DOUBLE BUFFER FOR TRIVIALLY COPYABLE TYPES
+// ---------------------------------------------------------------------------
 
 
 template <typename T>
-Saveable<T*>::Saveable()
-    : Updateable()
+SaveableSlots<T>::SaveableSlots( T const& t )
+    : _slots{ t, t }, _state( 0 )
+{}
+
+
+template <typename T>
+SaveableSlots<T>::SaveableSlots( SaveableSlots<T> const& o )
+    : _slots{ o.live(), o.live() }, _state( 0 )
+{}
+
+
+template <typename T>
+inline void SaveableSlots<T>::set( T const& t )
 {
-    _snap = _live = nullptr;
+    uint32_t state = _state.load( std::memory_order_relaxed );
+    uint32_t live  = state & 1;
+    uint32_t epoch = saveEpoch.load( std::memory_order_relaxed );
+    if ( state >> 1 != epoch )
+    {
+        // first write since the save began -- the live slot becomes the snapshot
+        live ^= 1;
+        _slots[ live ] = t;
+        _state.store( epoch << 1 | live, std::memory_order_release );
+        return;
+    }
+    _slots[ live ] = t;
 }
 
 
 template <typename T>
-Saveable<T*>::Saveable( T* const& t )
-    : Updateable()
+inline T& SaveableSlots<T>::edit()
 {
-    _snap = _live = t;
+    uint32_t state = _state.load( std::memory_order_relaxed );
+    uint32_t live  = state & 1;
+    uint32_t epoch = saveEpoch.load( std::memory_order_relaxed );
+    if ( state >> 1 != epoch )
+    {
+        _slots[ live ^ 1 ] = _slots[ live ];
+        live ^= 1;
+        _state.store( epoch << 1 | live, std::memory_order_release );
+    }
+    return _slots[ live ];
 }
 
 
 template <typename T>
-Saveable<T*>::Saveable( Saveable<T*> const& o )
-    : Updateable()
+inline T const& SaveableSlots<T>::live() const
 {
-    _snap = _live = o._live;
+    return _slots[ _state.load( std::memory_order_relaxed ) & 1 ];
 }
 
 
 template <typename T>
-Saveable<T*>::~Saveable()
-{}
+inline T const& SaveableSlots<T>::snap() const
+{
+    uint32_t state = _state.load( std::memory_order_acquire );
+    uint32_t live  = state & 1;
+    return _slots[ state >> 1 == saveEpoch.load( std::memory_order_relaxed ) ? live ^ 1 : live ];
+}
 
 
 template <typename T>
-void Saveable<T*>::set( T* const& t )
+inline T const& SaveableSlots<T>::get() const
 {
-    if (!isSaving)
+    uint32_t epoch = readEpoch;
+    if ( ! epoch )
     {
-        _snap = t;
+        return live();
     }
-    _live = t;
+    uint32_t state = _state.load( std::memory_order_acquire );
+    uint32_t live  = state & 1;
+    return _slots[ state >> 1 == epoch ? live ^ 1 : live ];
 }
 
 
 template <typename T>
-void Saveable<T*>::update()
+Saveable<T, typename std::enable_if<std::is_trivially_copyable<T>::value && ! std::is_pointer<T>::value>::type>::Saveable()
+    : SaveableSlots<T>( T() )
+{}
+
+
+template <typename T>
+Saveable<T, typename std::enable_if<std::is_trivially_copyable<T>::value && ! std::is_pointer<T>::value>::type>::Saveable( T const& t )
+    : SaveableSlots<T>( t )
+{}
+
+
+template <typename T>
+Saveable<T, typename std::enable_if<std::is_trivially_copyable<T>::value && ! std::is_pointer<T>::value>::type>::Saveable( Saveable<T> const& o )
+    : SaveableSlots<T>( o )
+{}
+
+
+template <typename T>
+inline Saveable<T>& Saveable<T, typename std::enable_if<std::is_trivially_copyable<T>::value && ! std::is_pointer<T>::value>::type>::operator =( T const& t )
 {
-    _snap = _live;
+    this->set( t );
+    return *this;
 }
 
 
 template <typename T>
-T* const& Saveable<T*>::live()
+inline Saveable<T>& Saveable<T, typename std::enable_if<std::is_trivially_copyable<T>::value && ! std::is_pointer<T>::value>::type>::operator =( Saveable<T> const& o )
 {
-    return _live;
+    this->set( o.live() );
+    return *this;
 }
 
 
 template <typename T>
-T* const& Saveable<T*>::snap()
+inline Saveable<T>& Saveable<T, typename std::enable_if<std::is_trivially_copyable<T>::value && ! std::is_pointer<T>::value>::type>::operator *=( T const& t )
 {
-    return _snap;
+    this->set( this->live() * t );
+    return *this;
 }
 
 
 template <typename T>
-Saveable<T*>& Saveable<T*>::operator =( T* const& t )
+inline Saveable<T>& Saveable<T, typename std::enable_if<std::is_trivially_copyable<T>::value && ! std::is_pointer<T>::value>::type>::operator /=( T const& t )
 {
-    set( t );
+    this->set( this->live() / t );
     return *this;
 }
 
 
 template <typename T>
-Saveable<T*>& Saveable<T*>::operator =( Saveable<T*> const& o )
+inline Saveable<T>& Saveable<T, typename std::enable_if<std::is_trivially_copyable<T>::value && ! std::is_pointer<T>::value>::type>::operator +=( T const& t )
 {
-    set( o._live );
+    this->set( this->live() + t );
+    return *this;
+}
+
+
+template <typename T>
+inline Saveable<T>& Saveable<T, typename std::enable_if<std::is_trivially_copyable<T>::value && ! std::is_pointer<T>::value>::type>::operator -=( T const& t )
+{
+    this->set( this->live() - t );
+    return *this;
+}
+
+
+template <typename T>
+inline Saveable<T, typename std::enable_if<std::is_trivially_copyable<T>::value && ! std::is_pointer<T>::value>::type>::operator T const&() const
+{
+    return this->get();
+}
+
+
+template <typename T>
+inline T const& Saveable<T, typename std::enable_if<std::is_trivially_copyable<T>::value && ! std::is_pointer<T>::value>::type>::operator ()() const
+{
+    return this->get();
+}
+
+
+template <typename T>
+inline T const* Saveable<T, typename std::enable_if<std::is_trivially_copyable<T>::value && ! std::is_pointer<T>::value>::type>::operator ->() const
+{
+    return &this->get();
+}
+
+
+//----------------------------------------------------------------------------
+// RAW POINTER SPECIALIZATION
+//----------------------------------------------------------------------------
+
+
+template <typename T>
+Saveable<T*>::Saveable()
+    : SaveableSlots<T*>( nullptr )
+{}
+
+
+template <typename T>
+Saveable<T*>::Saveable( T* const& t )
+    : SaveableSlots<T*>( t )
+{}
+
+
+template <typename T>
+Saveable<T*>::Saveable( Saveable<T*> const& o )
+    : SaveableSlots<T*>( o )
+{}
+
+
+template <typename T>
+inline Saveable<T*>& Saveable<T*>::operator =( T* const& t )
+{
+    this->set( t );
+    return *this;
+}
+
+
+template <typename T>
+inline Saveable<T*>& Saveable<T*>::operator =( Saveable<T*> const& o )
+{
+    this->set( o.live() );
     return *this;
 }
 
 
 template <typename T>
-Saveable<T*>::operator T* const&() const
+inline Saveable<T*>::operator T* const&() const
 {
-    return isSavingThread() ? _snap : _live;
+    return this->get();
 }
 
 
 template <typename T>
-T* const& Saveable<T*>::operator ()() const
+inline T* const& Saveable<T*>::operator ()() const
 {
-    return isSavingThread() ? _snap : _live;
+    return this->get();
 }
 
 
 template <typename T>
-T* const Saveable<T*>::operator ->() const
+inline T* Saveable<T*>::operator ->() const
 {
-    return isSavingThread() ? _snap : _live;
+    return this->get();
 }
 
 
@@ -333,10 +469,14 @@ Saveable<std::shared_ptr<T>>::~Saveable()
 template <typename T>
 void Saveable<std::shared_ptr<T>>::set( std::shared_ptr<T> const& t )
 {
-    if (!isSaving)
+    if (!setsAside())
     {
         _snap = t;
     }
+    else if (!isDirty())
+    {
+        markDirty();
+    }
     _live = t;
 }
 
@@ -381,28 +521,172 @@ Saveable<std::shared_ptr<T>>& Saveable<std::shared_ptr<T>>::operator =( Saveable
 template <typename T>
 Saveable<std::shared_ptr<T>>::operator bool() const
 {
-    return isSavingThread() ? _snap.get() : _live.get();
+    return readEpoch ? _snap.get() : _live.get();
 }
 
 
 template <typename T>
 Saveable<std::shared_ptr<T>>::operator std::shared_ptr<T> const&() const
 {
-    return isSavingThread() ? _snap : _live;
+    return readEpoch ? _snap : _live;
 }
 
 
 template <typename T>
 std::shared_ptr<T> const& Saveable<std::shared_ptr<T>>::operator ()() const
 {
-    return isSavingThread() ? _snap : _live;
+    return readEpoch ? _snap : _live;
 }
 
 
 template <typename T>
 T const* Saveable<std::shared_ptr<T>>::operator ->() const
 {
-    return isSavingThread() ? _snap.get() : _live.get();
+    return readEpoch ? _snap.get() : _live.get();
+}
+
+
+// ---------------------------------------------------------------------------
+// PERSISTENT CONTAINER SPECIALIZATION
+// ---------------------------------------------------------------------------
+
+
+template <typename T>
+Saveable<T, typename std::enable_if<IsPersistent<T>::value>::type>::Saveable()
+    : Updateable(), _slots(), _state( 0 )
+{}
+
+
+template <typename T>
+Saveable<T, typename std::enable_if<IsPersistent<T>::value>::type>::Saveable( T const& t )
+    : Updateable(), _slots{ t, T() }, _state( 0 )
+{}
+
+
+template <typename T>
+Saveable<T, typename std::enable_if<IsPersistent<T>::value>::type>::Saveable( T&& t )
+    : Updateable(), _slots{ std::move( t ), T() }, _state( 0 )
+{}
+
+
+template <typename T>
+Saveable<T, typename std::enable_if<IsPersistent<T>::value>::type>::Saveable( Saveable<T> const& o )
+    : Updateable(), _slots{ o.live(), T() }, _state( 0 )
+{}
+
+
+template <typename T>
+void Saveable<T, typename std::enable_if<IsPersistent<T>::value>::type>::set( T const& t )
+{
+    edit() = t;
+}
+
+
+template <typename T>
+void Saveable<T, typename std::enable_if<IsPersistent<T>::value>::type>::set( T&& t )
+{
+    edit() = std::move( t );
+}
+
+
+template <typename T>
+void Saveable<T, typename std::enable_if<IsPersistent<T>::value>::type>::update()
+{
+    // the save is over -- drop the copy it read
+    _slots[ ( _state.load( std::memory_order_relaxed ) & 1 ) ^ 1 ] = T();
+}
+
+
+template <typename T>
+T& Saveable<T, typename std::enable_if<IsPersistent<T>::value>::type>::edit()
+{
+    uint32_t state = _state.load( std::memory_order_relaxed );
+    uint32_t live  = state & 1;
+    uint32_t epoch = saveEpoch.load( std::memory_order_relaxed );
+    if ( state >> 1 != epoch && setsAside() )
+    {
+        // first write since the save began -- the live copy becomes the snapshot
+        _slots[ live ^ 1 ] = _slots[ live ];
+        live ^= 1;
+        _state.store( epoch << 1 | live, std::memory_order_release );
+        markDirty();
+    }
+    return _slots[ live ];
+}
+
+
+template <typename T>
+T const& Saveable<T, typename std::enable_if<IsPersistent<T>::value>::type>::live() const
+{
+    return _slots[ _state.load( std::memory_order_relaxed ) & 1 ];
+}
+
+
+template <typename T>
+T const& Saveable<T, typename std::enable_if<IsPersistent<T>::value>::type>::snap() const
+{
+    uint32_t state = _state.load( std::memory_order_acquire );
+    uint32_t live  = state & 1;
+    return _slots[ state >> 1 == saveEpoch.load( std::memory_order_relaxed ) ? live ^ 1 : live ];
+}
+
+
+template <typename T>
+Saveable<T>& Saveable<T, typename std::enable_if<IsPersistent<T>::value>::type>::operator =( T const& t )
+{
+    set( t );
+    return *this;
+}
+
+
+template <typename T>
+Saveable<T>& Saveable<T, typename std::enable_if<IsPersistent<T>::value>::type>::operator =( T&& t )
+{
+    set( std::move( t ));
+    return *this;
+}
+
+
+template <typename T>
+Saveable<T>& Saveable<T, typename std::enable_if<IsPersistent<T>::value>::type>::operator =( Saveable<T> const& o )
+{
+    set( o.live() );
+    return *this;
+}
+
+
+template <typename T>
+Saveable<T, typename std::enable_if<IsPersistent<T>::value>::type>::operator T const&() const
+{
+    return get();
+}
+
+
+template <typename T>
+T const& Saveable<T, typename std::enable_if<IsPersistent<T>::value>::type>::operator ()() const
+{
+    return get();
+}
+
+
+template <typename T>
+T const* Saveable<T, typename std::enable_if<IsPersistent<T>::value>::type>::operator ->() const
+{
+    return &get();
+}
+
+
+template <typename T>
+inline T const& Saveable<T, typename std::enable_if<IsPersistent<T>::value>::type>::get() const
+{
+    uint32_t epoch = readEpoch;
+    if ( ! epoch )
+    {
+        return live();
+    }
+    uint32_t state = _state.load( std::memory_order_acquire );
+    uint32_t live  = state & 1;
+    return _slots[ state >> 1 == epoch ? live ^ 1 : live ];
 }
 
 
@@ -440,6 +724,15 @@ SaveableVector2<T,U>::~SaveableVector2()
 {}
 
 
+template <typename T, typename U>
+SaveableVector2<T,U>& SaveableVector2<T,U>::operator =( Vector2<T,U> const& o )
+{
+    this->x = o.x;
+    this->y = o.y;
+    return *this;
+}
+
+
 template <typename T, typename U>
 SaveableVector2<T,U>::operator Vector2<T,U>() const
 {
@@ -576,7 +869,7 @@ Vector2<T,U> operator -( Vector2<Saveable<T>,U> const& lhs, V const& rhs )
 template <typename T, typename U, typename V>
 Vector2<T,U> operator -( Vector2<T,U> const& lhs, Saveable<V> const& rhs )
 {
-    return lhs.x - rhs();
+    return lhs - rhs();
 }
 
 
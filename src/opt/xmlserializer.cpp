@@ -19,7 +19,8 @@ using std::ostringstream;
 const string XML_INDENT = "  ";
 
 
-XmlSerializer::XmlSerializer()
+XmlSerializer::XmlSerializer( double time )
+    : time( time )
 {}
 
 
@@ -106,15 +107,25 @@ static inline string stations( XmlSerializer& x, station_ptrs_set_t o, string co
 {
     return ptrs( x, &XmlSerializer::station, o, "stations", indent );
 }
-static inline string ships( XmlSerializer& x, ship_ptrs_set_t o, string const& indent )
+static inline string faction( ShipFaction o )
+{
+    switch ( o )
+    {
+        case ShipFaction_Player  : return "Player";
+        case ShipFaction_Friend  : return "Friend";
+        case ShipFaction_Foe     : return "Foe";
+        default                  : return "Neutral";
+    }
+}
+static inline string ships( XmlSerializer& x, ship_ptrs_pset_t const& o, string const& indent )
 {
     return ptrs( x, &XmlSerializer::ship, o, "ships", indent );
 }
-static inline string weapons( XmlSerializer& x, weapon_ptrs_t o, string const& indent )
+static inline string weapons( XmlSerializer& x, weapon_ptrs_pvec_t const& o, string const& indent )
 {
     return ptrs( x, &XmlSerializer::weapon, o, "weapons", indent );
 }
-static inline string turrets( XmlSerializer& x, weapon_ptrs_t o, string const& indent )
+static inline string turrets( XmlSerializer& x, weapon_ptrs_pvec_t const& o, string const& indent )
 {
     return ptrs( x, &XmlSerializer::weapon, o, "turrets", indent );
 }
@@ -135,12 +146,44 @@ string XmlSerializer::sector( Sector const& o, string const& indent )
     os << indent << open( tagname, attrs )                 << endl
        << jumpgates( *this, o.jumpgates.all(), subindent ) << endl
        << stations( *this, o.stations, subindent )         << endl
-       << ships( *this, o.ships, subindent )               << endl
+       << ships( *this, o.ships(), subindent )               << endl
+       << traffic( o.traffic(), subindent )                << endl
        << indent << close( tagname );
     return os.str();
 }
 
 
+// Parked ships by faction and type -- empty unless the sector holds some
+string XmlSerializer::traffic( SectorTraffic const& o, string const& indent )
+{
+    static string const tagname = "traffic";
+    ostringstream os;
+    if ( o.total() )
+    {
+        string subindent = indent + XML_INDENT;
+        xml_attrs_t attrs = {{ "count", number( o.total() ) }};
+        if ( o.delta ) attrs.emplace_back( "delta", number( o.delta ));
+        os << indent << open( tagname, attrs ) << endl;
+        for ( size_t f = 0; f < ShipFaction_END; ++f )
+        {
+            for ( size_t t = 0; t < ShipType_END; ++t )
+            {
+                if ( ! o.counts[ f ][ t ] ) continue;
+                os << subindent
+                   << open( "parked", {
+                          { "faction", faction( static_cast<ShipFaction>( f )) },
+                          { "type",    shipClass( static_cast<ShipType>( t )) },
+                          { "count",   number( o.counts[ f ][ t ] ) },
+                      }, true )
+                   << endl;
+            }
+        }
+        os << indent << close( tagname );
+    }
+    return os.str();
+}
+
+
 string XmlSerializer::jumpgate( Jumpgate const& o, string const& indent )
 {
     static string const tagname = "jumpgate";
@@ -184,24 +227,16 @@ string XmlSerializer::ship( Ship const& o, string const& indent )
     static string const tagname = "ship";
     ostringstream os;
     string subindent = indent + XML_INDENT;
-    string faction;
-    switch ( o.faction )
-    {
-        case ShipFaction_Player  : faction = "Player";  break;
-        case ShipFaction_Friend  : faction = "Friend";  break;
-        case ShipFaction_Foe     : faction = "Foe";     break;
-        default                  : faction = "Neutral"; break;
-    }
     xml_attrs_t attrs = {
         { "id",           id( o.id ) },
         { "type",         shipClass( o.type ) },
-        { "faction",      faction },
+        { "faction",      faction( o.faction ) },
         { "code",         o.code },
         { "name",         o.name },
         { "max-hull",     number( o.maxHull ) },
         { "current-hull", number( o.currentHull ) },
 //        { "sector",       id( o.sector ) },
-        { "position",     vector2( o.position ) },
+        { "position",     vector2( o.positionAt( time )) },
         { "direction",    vector2( o.direction ) },
         { "speed",        number( o.speed ) },
     };
@@ -214,13 +249,14 @@ string XmlSerializer::ship( Ship const& o, string const& indent )
         attrs.emplace_back( "destination-sector",  id( o.destination->sector ));
         attrs.emplace_back( "destination-position", vector2( o.destination->position ));
     }
-    if ( o.target )        attrs.emplace_back( "target",  id( o.target ));
-    if ( o.docked )        attrs.emplace_back( "docked",  boolean( o.docked ));
-    if ( o.timeout > 0.0 ) attrs.emplace_back( "timeout", number( o.timeout ));
+    if ( o.journey )          attrs.emplace_back( "journey", id( o.journey ));
+    if ( o.target )           attrs.emplace_back( "target",  id( o.target ));
+    if ( o.docked )           attrs.emplace_back( "docked",  boolean( o.docked ));
+    if ( o.timeoutAt > time ) attrs.emplace_back( "timeout", number( o.timeoutAt - time ));
     os << indent << open( tagname, attrs ) << endl;
     string s;
-    if (( s = weapons( *this, o.weapons, subindent )).size() ) os << s << endl;
-    if (( s = turrets( *this, o.turrets, subindent )).size() ) os << s << endl;
+    if (( s = weapons( *this, o.weapons(), subindent )).size() ) os << s << endl;
+    if (( s = turrets( *this, o.turrets(), subindent )).size() ) os << s << endl;
     os << indent << close( tagname );
     return os.str();
 }
@@ -252,7 +288,7 @@ string XmlSerializer::weapon( Weapon const& o, string const& indent )
     };
     if ( o.target )         attrs.emplace_back( "target",          id( o.target ));
     if ( o.weaponPosition ) attrs.emplace_back( "weapon-position", weaponPosition );
-    if ( o.cooldown > 0.f ) attrs.emplace_back( "cooldown",        number( o.cooldown ));
+    if ( o.readyAt > time ) attrs.emplace_back( "cooldown",        number( o.readyAt - time ));
     os << indent << open( tagname, attrs, true );
     return os.str();
 }
@@ -261,12 +297,23 @@ string XmlSerializer::weapon( Weapon const& o, string const& indent )
 string XmlSerializer::savegame( sectors_t   const& sectors,
                                 jumpgates_t const& jumpgates,
                                 stations_t  const& stations,
-                                ships_t     const& ships,
+                                ships_t     const&, // records are written with their sectors
                                 string      const& indent )
 {
     static string const tagname = "savegame";
     ostringstream os;
     string subindent = indent + XML_INDENT;
+    // counted off the rosters and traffic written below -- Ship::parked
+    // isn't Saveable, so mid-save it can be ahead of them
+    size_t live = 0, parked = 0;
+    for ( auto& sectorRow : sectors )
+    {
+        for ( auto& v : sectorRow )
+        {
+            live   += v.ships().size();
+            parked += v.traffic->total();
+        }
+    }
     os << indent << open( tagname ) << endl
        << subindent
        << open( "sectors", {{ "count", number( sectors.size() * sectors[0].size() ) }}, true )
@@ -278,7 +325,7 @@ string XmlSerializer::savegame( sectors_t   const& sectors,
        << open( "stations", {{ "count", number( stations.size() ) }}, true )
        << endl
        << subindent
-       << open( "ships", {{ "count", number( ships.size() ) }}, true )
+       << open( "ships", {{ "count", number( live ) }, { "parked", number( parked ) }}, true )
        << endl;
     for ( auto& sectorRow : sectors )
     {
@@ -30,7 +30,9 @@ extern const string XML_INDENT;
 class XmlSerializer
 {
 public:
-    XmlSerializer();
+    double time; // sim time (seconds) at which ship positions are evaluated
+
+    XmlSerializer( double time=0.0 );
     ~XmlSerializer();
 
     // General XML
@@ -52,6 +54,7 @@ public:
 
     // Tags
     string sector( Sector const& o, string const& indent="" );
+    string traffic( SectorTraffic const& o, string const& indent="" );
     string jumpgate( Jumpgate const& o, string const& indent="" );
     string station( Station const& o, string const& indent="" );
     string ship( Ship const& o, string const& indent="" );
@@ -0,0 +1,65 @@
+// pingpong.cpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#include "pingpong.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include "opt/saveable.hpp"
+
+
+namespace tinyspace {
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+
+TickBuffers::TickBuffers( bool isEnabled )
+    : isEnabled( isEnabled ), swaps( 0 ), diverged( 0 ), swapTime( 0.0 ), maxSwap( 0.0 ), _isOpen( false )
+{}
+
+
+TickBuffers::~TickBuffers()
+{
+    if ( _isOpen )
+    {
+        swap();
+    }
+}
+
+
+bool TickBuffers::isOpen() const
+{
+    return _isOpen;
+}
+
+
+void TickBuffers::open()
+{
+    if ( ! isEnabled || _isOpen )
+    {
+        return;
+    }
+    beginSnapshot();
+    _isOpen = true;
+}
+
+
+void TickBuffers::swap()
+{
+    if ( ! _isOpen )
+    {
+        return;
+    }
+    auto start = steady_clock::now();
+    diverged   = endSnapshot();
+    _isOpen    = false;
+
+    double elapsed = duration<double>( steady_clock::now() - start ).count();
+    ++swaps;
+    swapTime += elapsed;
+    maxSwap   = std::max( maxSwap, elapsed );
+}
+
+
+} // tinyspace
@@ -0,0 +1,62 @@
+// pingpong.hpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#ifndef _TINYSPACE_PINGPONG_HPP_
+#define _TINYSPACE_PINGPONG_HPP_
+
+
+#include <cstddef>
+
+
+namespace tinyspace {
+
+
+// Ping-pong world state (--double-buffer).
+//
+// Every Saveable field already holds two values (opt/saveable.hpp). Double
+// buffered, a snapshot opens as each tick begins: the front buffer, the
+// world as the last tick left it. The tick writes its results into the back
+// -- the first write to each field switches it to its other slot -- and the
+// swap at its end closes the snapshot, making the back the next front.
+//
+// Only combat reads the front (Schedule::doubleBuffered): other ships' hull
+// and docking are judged as the tick began, so shots and kills within a tick
+// are simultaneous and don't depend on the order ships are visited.
+// Everything else -- positions and directions, sector rosters, traffic
+// counts, the schedule's queues, the traffic pool -- is read and written in
+// place as before, and a ship jumping sectors edits both rosters. Sectors
+// still share writable state, so ticks stay on one thread.
+//
+// Readers on other threads (UI, stats) hold a SnapshotReader and read the
+// front without locks while a tick runs, and let go before it ends -- the
+// front is gone at the swap. Between ticks the two buffers agree, so readers
+// there read live. A save spans many ticks, more than two slots can carry
+// alongside a per-tick front, so double buffered, saves fork (autosave.hpp).
+struct TickBuffers
+{
+    bool   isEnabled;
+    size_t swaps;
+    size_t diverged; // fields the latest tick wrote
+    double swapTime; // wall seconds spent swapping -- closing the snapshot, reconciling what the tick wrote
+    double maxSwap;  // ...the longest single swap
+
+    TickBuffers( bool isEnabled );
+    ~TickBuffers(); // swaps a tick left open
+
+    bool isOpen() const;
+
+    // As a tick begins -- freezes the front buffer
+    void open();
+    // As a tick ends -- the back buffer becomes the front
+    void swap();
+
+private:
+    bool _isOpen;
+};
+
+
+} // tinyspace
+
+
+#endif // _TINYSPACE_PINGPONG_HPP_
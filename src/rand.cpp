@@ -5,18 +5,64 @@
 #include "rand.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <iomanip>
 #include <sstream>
 #include "constants.hpp"
+#include "routes.hpp"
 
 
 namespace tinyspace {
 
 
+namespace {
+__thread uint64_t randState = 0x9E3779B97F4A7C15ull; // xorshift64* state -- never zero
+}
+
+
+void seedRand( uint64_t seed )
+{
+    randState = seedStream( seed );
+}
+
+
+uint64_t randStream()
+{
+    return randState;
+}
+
+
+void setRandStream( uint64_t stream )
+{
+    randState = stream ? stream : 1;
+}
+
+
+uint64_t seedStream( uint64_t seed )
+{
+    // splitmix64 scramble, so neighboring seeds start far apart
+    uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+    z = ( z ^ ( z >> 30 )) * 0xBF58476D1CE4E5B9ull;
+    z = ( z ^ ( z >> 27 )) * 0x94D049BB133111EBull;
+    z = z ^ ( z >> 31 );
+    return z ? z : 1;
+}
+
+
+uint32_t randInt()
+{
+    randState ^= randState >> 12;
+    randState ^= randState << 25;
+    randState ^= randState >> 27;
+    return static_cast<uint32_t>(( randState * 0x2545F4914F6CDD1Dull ) >> 32 );
+}
+
+
 // Returns a value between min and max (inclusive)
 float randFloat( float min, float max )
 {
-    return min + ( static_cast<float>( rand() ) / static_cast<float>( RAND_MAX/( max-min )));
+    return min + ( max-min ) * static_cast<float>( randInt() / 4294967295.0 );
 }
 
 
@@ -59,7 +105,7 @@ direction_t randDirection() {
 
 ShipType randShipType()
 {
-    return static_cast<ShipType>( 1 + ( rand() % ( ShipType_END - 1 )));
+    return static_cast<ShipType>( 1 + ( randInt() % ( ShipType_END - 1 )));
 }
 
 
@@ -69,12 +115,12 @@ string randCode()
     size_t i;
     for ( i = 0; i < 3; ++i )
     {
-        buf[ i ] = 'A' + static_cast<char>( rand() % ( 'Z'-'A'+1 ));
+        buf[ i ] = 'A' + static_cast<char>( randInt() % ( 'Z'-'A'+1 ));
     }
     buf[3] = '-';
     for ( i = 4; i < 7; ++i )
     {
-        buf[ i ] = '0' + static_cast<char>( rand() % ( '9'-'0'+1 ));
+        buf[ i ] = '0' + static_cast<char>( randInt() % ( '9'-'0'+1 ));
     }
     buf[7] = '\0';
     return buf;
@@ -83,10 +129,11 @@ string randCode()
 
 string randName( ShipType const& shipType )
 {
-    static size_t scoutCur     = 0;
-    static size_t corvetteCur  = 0;
-    static size_t frigateCur   = 0;
-    static size_t transportCur = 0;
+    // shared by worlds stepping on other threads (world.hpp) -- names stay unique
+    static std::atomic<size_t> scoutCur( 0 );
+    static std::atomic<size_t> corvetteCur( 0 );
+    static std::atomic<size_t> frigateCur( 0 );
+    static std::atomic<size_t> transportCur( 0 );
     std::ostringstream os;
     switch ( shipType )
     {
@@ -146,7 +193,7 @@ destination_ptr_t randDestination(
 
         if ( ! potentialDestinations.empty() )
         {
-            auto destinationObject = potentialDestinations[ rand() % potentialDestinations.size() ];
+            auto destinationObject = potentialDestinations[ randInt() % potentialDestinations.size() ];
             auto r = destination_ptr_t( new Destination( *destinationObject ));
             return r;
         }
@@ -155,47 +202,31 @@ destination_ptr_t randDestination(
 }
 
 
-float chanceToHit(
-    WeaponType weaponType,
-    bool isTurret,
-    TargetType targetType,
-    distance_t distance )
+Sector* randJourney( Sector const& sector )
 {
-    distance_t range;
-    switch ( weaponType )
+    Routes const* routes = sector.routes;
+    size_t count = routes ? routes->sectorCount() : 0;
+    if ( count < 2 )
     {
-        case WeaponType_Pulse:  range = PULSE_RANGE;  break;
-        case WeaponType_Cannon: range = CANNON_RANGE; break;
-        case WeaponType_Beam:   range = BEAM_RANGE;   break;
-        default:                range = 0;            break;
+        return nullptr;
     }
-    if ( isTurret )
+    size_t index = randInt() % ( count - 1 );
+    if ( index >= routes->indexOf( sector ))
     {
-        range *= TURRET_RANGE_SCALE;
-    }
-    if ( range < distance )
-    {
-        return 0.f;
+        ++index; // skip the current sector
     }
+    return routes->sectorAt( sector, index );
+}
 
-    float chance;
-    switch ( weaponType )
-    {
-        case WeaponType_Pulse:  chance = PULSE_ACCURACY;  break;
-        case WeaponType_Cannon: chance = CANNON_ACCURACY; break;
-        case WeaponType_Beam:   chance = BEAM_ACCURACY;   break;
-        default:                chance = 0;               break;
-    }
-    switch ( targetType )
-    {
-        case TargetType_Courier:    chance *= COURIER_ACCURACY_MULTIPLIER;   break;
-        case TargetType_Transport:  chance *= TRANSPORT_ACCURACY_MULTIPLIER; break;
-        case TargetType_Scout:      chance *= SCOUT_ACCURACY_MULTIPLIER;     break;
-        case TargetType_Corvette:   chance *= CORVETTE_ACCURACY_MULTIPLIER;  break;
-        case TargetType_Frigate:    chance *= FRIGATE_ACCURACY_MULTIPLIER;   break;
-        default:                                                             break;
-    }
-    return chance;
+
+float chanceToHit(
+    WeaponType weaponType,
+    bool isTurret,
+    TargetType targetType,
+    distance_t distance )
+{
+    HitChance const& hitChance = HIT_CHANCE[ weaponType ][ isTurret ][ targetType ];
+    return distance * distance > hitChance.rangeSquared ? 0.f : hitChance.accuracy;
 }
 
 
@@ -212,8 +243,9 @@ float chanceToHit(
     {
         return 0.f;
     }
-    direction_t targetVector = target->position - parent->position;
-    if ( targetVector.magnitude() > MAX_TO_HIT_RANGE )
+    direction_t targetVector    = target->position - parent->position;
+    distance_t  distanceSquared = targetVector.magnitudeSquared();
+    if ( distanceSquared > MAX_TO_HIT_RANGE_SQUARED )
     {
         return 0.f;
     }
@@ -226,7 +258,9 @@ float chanceToHit(
                             : weaponPosition == WeaponPosition_Starboard ? dir.starboard()
                             :                                              dir;
             // +/-45 = 90 degree aim window
-            if ( abs( aim.angleDeg( targetVector )) > 45 )
+            // cos(45) == sin(45), so the target is inside the window when the
+            // aim's dot product is at least the magnitude of its cross product
+            if ( aim.dot( targetVector ) < std::abs( aim.cross( targetVector )))
             {
                 return 0.f;
             }
@@ -241,7 +275,8 @@ float chanceToHit(
     {
         targetType = shipTypeToTargetType( targetShip->type );
     }
-    return chanceToHit( weapon.type, isTurret, targetType, targetVector.magnitude() );
+    HitChance const& hitChance = HIT_CHANCE[ weapon.type ][ isTurret ][ targetType ];
+    return distanceSquared > hitChance.rangeSquared ? 0.f : hitChance.accuracy;
 }
 
 
@@ -6,6 +6,7 @@
 #define _TINYSPACE_RAND_HPP_
 
 
+#include <cstdint>
 #include "types.hpp"
 #include "models.hpp"
 
@@ -13,6 +14,20 @@
 namespace tinyspace {
 
 
+// Every random draw in the simulation comes from one seeded generator, so a
+// run is reproduced exactly by its seed and per-tick inputs (see replay.hpp)
+void seedRand( uint64_t seed );
+
+// The generator is per thread -- a world stepping on another thread carries
+// its own stream and swaps it in while it steps (see world.hpp)
+uint64_t randStream();
+void setRandStream( uint64_t stream );
+// The stream seedRand( seed ) starts
+uint64_t seedStream( uint64_t seed );
+
+// Returns a uniformly distributed 32-bit value
+uint32_t randInt();
+
 // Returns a value between min and max (inclusive)
 float randFloat( float min, float max );
 float randFloat( float max=1.0f );
@@ -35,6 +50,10 @@ destination_ptr_t randDestination(
     float miscChance=0.f,
     location_ptrs_t* excludes=nullptr);
 
+// Returns a random sector reachable from the given sector by jumpgate, or
+// nullptr if there is none
+Sector* randJourney( Sector const& sector );
+
 float chanceToHit(
     WeaponType weaponType,
     bool isTurret,
@@ -0,0 +1,204 @@
+// replay.cpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#include "replay.hpp"
+
+#include <cstring>
+#include "constants.hpp"
+
+
+namespace tinyspace {
+
+
+namespace {
+
+char     const REPLAY_MAGIC[ 4 ] = { 'T', 'S', 'R', 'P' };
+uint32_t const REPLAY_VERSION    = 1;
+
+// World constants the recorded run was generated from
+struct ReplayWorld
+{
+    uint64_t sectorRows;
+    uint64_t sectorCols;
+    uint64_t shipCount;
+    float    sectorWidth;
+    float    sectorHeight;
+};
+
+ReplayWorld currentWorld()
+{
+    return { SECTOR_BOUNDS.x, SECTOR_BOUNDS.y, SHIP_COUNT, SECTOR_SIZE.x, SECTOR_SIZE.y };
+}
+
+template <typename T>
+void write( ofstream& file, T const& value )
+{
+    file.write( reinterpret_cast<char const*>( &value ), sizeof( value ));
+}
+
+template <typename T>
+bool read( ifstream& file, T& value )
+{
+    return static_cast<bool>( file.read( reinterpret_cast<char*>( &value ), sizeof( value )));
+}
+
+} // anonymous
+
+
+ReplayConfig::ReplayConfig()
+    : seed( 0 ), useJumpgates( true ), useKinetic( false ), useShotCombat( false ), useDoubleBuffer( false )
+{}
+
+
+ReplayConfig::~ReplayConfig()
+{}
+
+
+ReplayTick::ReplayTick( double delta, BudgetLevel level )
+    : delta( delta ), level( level )
+{}
+
+
+ReplayTick::~ReplayTick()
+{}
+
+
+bool ReplayTick::operator==( ReplayTick const& other ) const
+{
+    return delta == other.delta && level == other.level;
+}
+
+
+// ---------------------------------------------------------------------------
+
+
+ReplayRecorder::ReplayRecorder()
+    : _file(), _run(), _runLength( 0 )
+{}
+
+
+ReplayRecorder::~ReplayRecorder()
+{
+    flush();
+}
+
+
+bool ReplayRecorder::open( string const& path, ReplayConfig const& config )
+{
+    _file.open( path, std::ios::binary | std::ios::trunc );
+    if ( ! _file )
+    {
+        return false;
+    }
+
+    ReplayWorld world = currentWorld();
+    uint8_t flags = ( config.useJumpgates    ? 1 : 0 )
+                  | ( config.useKinetic      ? 2 : 0 )
+                  | ( config.useShotCombat   ? 4 : 0 )
+                  | ( config.useDoubleBuffer ? 8 : 0 );
+
+    _file.write( REPLAY_MAGIC, sizeof( REPLAY_MAGIC ));
+    write( _file, REPLAY_VERSION );
+    write( _file, world );
+    write( _file, config.seed );
+    write( _file, flags );
+    _file.flush();
+    return static_cast<bool>( _file );
+}
+
+
+bool ReplayRecorder::isOpen() const
+{
+    return _file.is_open();
+}
+
+
+void ReplayRecorder::record( ReplayTick const& tick )
+{
+    if ( _runLength && ( tick == _run ) && _runLength < UINT32_MAX )
+    {
+        ++_runLength;
+        return;
+    }
+    flush();
+    _run       = tick;
+    _runLength = 1;
+}
+
+
+void ReplayRecorder::flush()
+{
+    if ( ! _runLength || ! _file.is_open() )
+    {
+        return;
+    }
+    uint8_t level = static_cast<uint8_t>( _run.level );
+    write( _file, _runLength );
+    write( _file, _run.delta );
+    write( _file, level );
+    _file.flush(); // a killed run keeps everything up to its last completed run
+    _runLength = 0;
+}
+
+
+// ---------------------------------------------------------------------------
+
+
+ReplayPlayer::ReplayPlayer()
+    : _file(), _run(), _runLength( 0 )
+{}
+
+
+ReplayPlayer::~ReplayPlayer()
+{}
+
+
+bool ReplayPlayer::open( string const& path, ReplayConfig& config )
+{
+    _file.open( path, std::ios::binary );
+
+    char        magic[ sizeof( REPLAY_MAGIC ) ];
+    uint32_t    version;
+    ReplayWorld world, expected = currentWorld();
+    uint8_t     flags;
+    if ( ! _file
+    ||   ! _file.read( magic, sizeof( magic ))
+    ||   memcmp( magic, REPLAY_MAGIC, sizeof( magic )) != 0
+    ||   ! read( _file, version ) || version != REPLAY_VERSION
+    ||   ! read( _file, world )
+    ||   memcmp( &world, &expected, sizeof( world )) != 0
+    ||   ! read( _file, config.seed )
+    ||   ! read( _file, flags ))
+    {
+        return false;
+    }
+
+    config.useJumpgates    = flags & 1;
+    config.useKinetic      = flags & 2;
+    config.useShotCombat   = flags & 4;
+    config.useDoubleBuffer = flags & 8;
+    return true;
+}
+
+
+bool ReplayPlayer::next( ReplayTick& tick )
+{
+    if ( ! _runLength )
+    {
+        uint8_t level;
+        if ( ! read( _file, _runLength ) || ! read( _file, _run.delta ) || ! read( _file, level )
+        ||   level >= BudgetLevel_END )
+        {
+            _runLength = 0;
+            return false;
+        }
+        _run.level = static_cast<BudgetLevel>( level );
+    }
+    --_runLength;
+    tick = _run;
+    return true;
+}
+
+
+} // tinyspace
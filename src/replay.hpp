@@ -0,0 +1,97 @@
+// replay.hpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#ifndef _TINYSPACE_REPLAY_HPP_
+#define _TINYSPACE_REPLAY_HPP_
+
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "budget.hpp"
+
+
+namespace tinyspace {
+
+
+using std::ifstream;
+using std::ofstream;
+using std::string;
+
+
+// Everything a run depends on besides its per-tick inputs
+struct ReplayConfig
+{
+    uint64_t seed;
+    bool     useJumpgates;
+    bool     useKinetic;
+    bool     useShotCombat;
+    bool     useDoubleBuffer;
+
+    ReplayConfig();
+    ~ReplayConfig();
+};
+
+
+// A tick's external inputs -- the simulated delta, and the fidelity the
+// budget controller had shed going into the tick
+struct ReplayTick
+{
+    double      delta; // seconds
+    BudgetLevel level;
+
+    ReplayTick( double delta=0.0, BudgetLevel level=BudgetLevel_Nominal );
+    ~ReplayTick();
+
+    bool operator==( ReplayTick const& other ) const;
+};
+
+
+// Replay log.
+//
+// A header holds the config and the world constants it was recorded with
+// (a log only replays against the build that shares them), followed by runs
+// of identical ticks as { count, delta, level }. Fixed-step runs collapse to
+// a single entry. Values are written in native byte order.
+struct ReplayRecorder
+{
+    ReplayRecorder();
+    ~ReplayRecorder(); // flushes the pending run
+
+    bool open( string const& path, ReplayConfig const& config );
+    bool isOpen() const;
+
+    void record( ReplayTick const& tick );
+
+private:
+    ofstream   _file;
+    ReplayTick _run;
+    uint32_t   _runLength;
+
+    void flush();
+};
+
+
+struct ReplayPlayer
+{
+    ReplayPlayer();
+    ~ReplayPlayer();
+
+    // Reads the header -- fails on a missing file or mismatched world constants
+    bool open( string const& path, ReplayConfig& config );
+
+    // Returns false once the log is exhausted
+    bool next( ReplayTick& tick );
+
+private:
+    ifstream   _file;
+    ReplayTick _run;
+    uint32_t   _runLength;
+};
+
+
+} // tinyspace
+
+
+#endif // _TINYSPACE_REPLAY_HPP_
@@ -0,0 +1,314 @@
+// replica.cpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#include "replica.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <new>
+#include <thread>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "constants.hpp"
+#include "statehash.hpp"
+
+
+namespace tinyspace {
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+
+namespace {
+
+uint64_t const MAGIC = 0x5453524550313031ull; // "TSREP101"
+
+
+struct ReplicaRecord
+{
+    uint64_t tick;
+    double   delta;   // seconds
+    uint32_t level;   // BudgetLevel
+    uint32_t hasHash;
+    uint64_t hash;    // state hash the tick left, every REPLICA_CHECK_TICKS
+};
+
+size_t const RING_RECORDS = REPLICA_RING_BYTES / sizeof( ReplicaRecord );
+
+} // anonymous
+
+
+// Head of the shared segment -- the ring of records follows it
+struct ReplicaShared
+{
+    std::atomic<uint64_t> magic;    // MAGIC once the rest is set
+    pid_t                 primary;
+    uint64_t              seed;
+    uint8_t               useJumpgates, useKinetic, useShotCombat, useDoubleBuffer;
+    uint64_t              sectorRows, sectorCols, shipCount; // world constants the replica's build has to share
+    std::atomic<uint32_t> isClosed; // the primary finished and unlinked the segment
+
+    // each side writes its own counter, on its own cache line
+    alignas( 64 ) std::atomic<uint64_t> head; // records ever written -- the primary's
+    alignas( 64 ) std::atomic<uint64_t> tail; // records ever consumed -- the replica's
+
+    ReplicaRecord* ring()
+    {
+        return reinterpret_cast<ReplicaRecord*>( this + 1 );
+    }
+};
+
+
+// ---------------------------------------------------------------------------
+// PRIMARY
+// ---------------------------------------------------------------------------
+
+
+ReplicaFeed::ReplicaFeed( string const& name, ReplayConfig const& config )
+    : records( 0 ), checks( 0 ), dropped( 0 ), _name(), _fd( -1 ), _shared( nullptr )
+{
+    if ( name.empty() )
+    {
+        return;
+    }
+    _name = "/tinyspace-" + name;
+    shm_unlink( _name.c_str() ); // left by a primary that died unfollowed
+
+    // populated up front, so ticks don't take the page faults
+    size_t const size = sizeof( ReplicaShared ) + RING_RECORDS * sizeof( ReplicaRecord );
+    _fd = shm_open( _name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600 );
+    void* memory = _fd >= 0 && ftruncate( _fd, size ) == 0
+        ? mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, 0 )
+        : MAP_FAILED;
+    if ( memory == MAP_FAILED )
+    {
+        if ( _fd >= 0 )
+        {
+            close( _fd );
+            shm_unlink( _name.c_str() );
+        }
+        _fd = -1;
+        return;
+    }
+
+    auto shared = new ( memory ) ReplicaShared();
+    shared->primary         = getpid();
+    shared->seed            = config.seed;
+    shared->useJumpgates    = config.useJumpgates;
+    shared->useKinetic      = config.useKinetic;
+    shared->useShotCombat   = config.useShotCombat;
+    shared->useDoubleBuffer = config.useDoubleBuffer;
+    shared->sectorRows      = SECTOR_BOUNDS.x;
+    shared->sectorCols      = SECTOR_BOUNDS.y;
+    shared->shipCount       = SHIP_COUNT;
+    shared->magic.store( MAGIC, std::memory_order_release );
+    _shared = shared;
+}
+
+
+ReplicaFeed::~ReplicaFeed()
+{
+    if ( ! isOpen() )
+    {
+        return;
+    }
+    // an attached replica keeps its mapping, and drains it before taking over
+    shm_unlink( _name.c_str() );
+    static_cast<ReplicaShared*>( _shared )->isClosed.store( 1, std::memory_order_release );
+    munmap( _shared, sizeof( ReplicaShared ) + RING_RECORDS * sizeof( ReplicaRecord ));
+    close( _fd );
+}
+
+
+bool ReplicaFeed::isOpen() const
+{
+    return _shared != nullptr;
+}
+
+
+void ReplicaFeed::publish( size_t tick, ReplayTick const& input, World const& world )
+{
+    if ( ! isOpen() )
+    {
+        return;
+    }
+    auto& shared  = *static_cast<ReplicaShared*>( _shared );
+    uint64_t head = shared.head.load( std::memory_order_relaxed );
+    if ( head - shared.tail.load( std::memory_order_acquire ) == RING_RECORDS )
+    {
+        ++dropped;
+        return;
+    }
+
+    ReplicaRecord& record = shared.ring()[ head % RING_RECORDS ];
+    record.tick    = tick;
+    record.delta   = input.delta;
+    record.level   = input.level;
+    record.hasHash = tick % REPLICA_CHECK_TICKS == 0;
+    record.hash    = record.hasHash ? hashState( world.schedule, world.sectors, world.ships, world.locality ) : 0;
+    shared.head.store( head + 1, std::memory_order_release );
+
+    ++records;
+    if ( record.hasHash ) ++checks;
+}
+
+
+// ---------------------------------------------------------------------------
+// REPLICA
+// ---------------------------------------------------------------------------
+
+
+Replica::Replica()
+    : ticks( 0 ),
+      _name(), _fd( -1 ), _shared( nullptr ), _size( 0 ), _tail( 0 ), _tick( 0 ), _hasHash( false ), _hash( 0 ),
+      _error()
+{}
+
+
+Replica::~Replica()
+{
+    release();
+}
+
+
+bool Replica::attach( string const& name, ReplayConfig& config )
+{
+    _name = "/tinyspace-" + name;
+    auto start = steady_clock::now();
+    while ( true )
+    {
+        _fd = shm_open( _name.c_str(), O_RDWR, 0 );
+        struct stat status;
+        if ( _fd >= 0 && fstat( _fd, &status ) == 0
+            && static_cast<size_t>( status.st_size ) == sizeof( ReplicaShared ) + RING_RECORDS * sizeof( ReplicaRecord ))
+        {
+            void* memory = mmap( nullptr, status.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0 );
+            if ( memory != MAP_FAILED )
+            {
+                if ( static_cast<ReplicaShared*>( memory )->magic.load( std::memory_order_acquire ) == MAGIC )
+                {
+                    _shared = memory;
+                    _size   = status.st_size;
+                    break;
+                }
+                munmap( memory, status.st_size );
+            }
+        }
+        if ( _fd >= 0 )
+        {
+            close( _fd );
+            _fd = -1;
+        }
+        if ( duration<double>( steady_clock::now() - start ).count() > REPLICA_ATTACH_TIMEOUT )
+        {
+            return false;
+        }
+        std::this_thread::sleep_for( duration<double>( REPLICA_POLL_TIME ));
+    }
+
+    auto& shared = *static_cast<ReplicaShared*>( _shared );
+    if ( shared.sectorRows != SECTOR_BOUNDS.x || shared.sectorCols != SECTOR_BOUNDS.y || shared.shipCount != SHIP_COUNT )
+    {
+        release();
+        return false;
+    }
+    config.seed            = shared.seed;
+    config.useJumpgates    = shared.useJumpgates;
+    config.useKinetic      = shared.useKinetic;
+    config.useShotCombat   = shared.useShotCombat;
+    config.useDoubleBuffer = shared.useDoubleBuffer;
+    _tail = shared.tail.load( std::memory_order_acquire );
+    return true;
+}
+
+
+bool Replica::isPrimaryGone() const
+{
+    auto& shared = *static_cast<ReplicaShared*>( _shared );
+    return shared.isClosed.load( std::memory_order_acquire )
+        || ( kill( shared.primary, 0 ) != 0 && errno == ESRCH );
+}
+
+
+bool Replica::next( ReplayTick& input )
+{
+    if ( ! _shared || ! _error.empty() )
+    {
+        return false;
+    }
+    auto& shared = *static_cast<ReplicaShared*>( _shared );
+    while ( shared.head.load( std::memory_order_acquire ) == _tail )
+    {
+        // the primary's last record lands before it's seen to be gone
+        if ( isPrimaryGone() && shared.head.load( std::memory_order_acquire ) == _tail )
+        {
+            return false;
+        }
+        std::this_thread::sleep_for( duration<double>( REPLICA_POLL_TIME ));
+    }
+
+    ReplicaRecord record = shared.ring()[ _tail % RING_RECORDS ];
+    shared.tail.store( ++_tail, std::memory_order_release );
+    if ( record.tick != _tick + 1 )
+    {
+        _error = "missed ticks " + std::to_string( _tick + 1 ) + " to " + std::to_string( record.tick - 1 )
+               + " (the ring was full)";
+        return false;
+    }
+
+    _tick    = record.tick;
+    _hasHash = record.hasHash;
+    _hash    = record.hash;
+    input    = ReplayTick( record.delta, static_cast<BudgetLevel>( record.level ));
+    ++ticks;
+    return true;
+}
+
+
+bool Replica::check( World const& world )
+{
+    if ( _hasHash && hashState( world.schedule, world.sectors, world.ships, world.locality ) != _hash )
+    {
+        _error = "diverged from the primary at tick " + std::to_string( _tick );
+        return false;
+    }
+    return true;
+}
+
+
+string const& Replica::error() const
+{
+    return _error;
+}
+
+
+void Replica::takeOver()
+{
+    if ( _shared && ! static_cast<ReplicaShared*>( _shared )->isClosed.load( std::memory_order_acquire ))
+    {
+        shm_unlink( _name.c_str() ); // the primary died with it linked
+    }
+    release();
+}
+
+
+void Replica::release()
+{
+    if ( _shared )
+    {
+        munmap( _shared, _size );
+        _shared = nullptr;
+    }
+    if ( _fd >= 0 )
+    {
+        close( _fd );
+        _fd = -1;
+    }
+}
+
+
+} // tinyspace
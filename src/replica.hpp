@@ -0,0 +1,106 @@
+// replica.hpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#ifndef _TINYSPACE_REPLICA_HPP_
+#define _TINYSPACE_REPLICA_HPP_
+
+
+#include <cstdint>
+#include <string>
+#include "replay.hpp"
+#include "world.hpp"
+
+
+namespace tinyspace {
+using std::string;
+
+
+// Hot standby.
+//
+// A primary (--publish NAME) writes a record of each tick into a ring in
+// shared memory (POSIX shm /tinyspace-NAME, REPLICA_RING_BYTES). A replica
+// (--replica NAME) on the same build attaches, builds its world from the
+// primary's config, and steps it tick for tick on the same inputs. Runs are
+// reproducible (replay.hpp), so the two worlds stay identical, and once the
+// primary is gone the replica carries on from the last tick it stepped --
+// its world is already in memory, whole, and nothing is reloaded.
+//
+// A tick's record is what a replay log keeps of it -- the simulated delta
+// and the budget level -- plus, every REPLICA_CHECK_TICKS ticks, the state
+// hash it left. A replica whose hash disagrees stops following rather than
+// take over a different world.
+//
+// The primary never waits: a record that doesn't fit the ring is dropped.
+// Until a replica drains it the ring holds the run from its first tick, so a
+// replica may attach late while it does. One that misses a tick -- late,
+// after the ring filled, or behind by a whole ring -- can't step the ticks it
+// missed, and stops.
+struct ReplicaFeed
+{
+    size_t records; // ticks published
+    size_t checks;  // ...of them with a state hash
+    size_t dropped; // ticks that didn't fit the ring
+
+    // Creates the ring for name -- nothing is published without one
+    ReplicaFeed( string const& name, ReplayConfig const& config );
+    ~ReplicaFeed(); // marks the stream closed
+
+    bool isOpen() const;
+
+    // After a tick -- tick is its number, and world as the tick left it
+    void publish( size_t tick, ReplayTick const& input, World const& world );
+
+private:
+    string _name;
+    int    _fd;
+    void*  _shared; // ReplicaShared, followed by the ring
+};
+
+
+// The replica's side -- a replay fed by a running primary
+struct Replica
+{
+    size_t ticks; // stepped on the primary's records
+
+    Replica();
+    ~Replica();
+
+    // Waits up to REPLICA_ATTACH_TIMEOUT for name's primary, and takes its config
+    bool attach( string const& name, ReplayConfig& config );
+
+    // Waits for the primary's next tick -- false once the primary is gone
+    // and every tick it published has been returned, or once the stream
+    // can't be followed (error)
+    bool next( ReplayTick& input );
+
+    // After stepping the tick next returned -- false if the primary's state
+    // hash for it disagrees
+    bool check( World const& world );
+
+    // Why following stopped short of the primary's last tick (empty if it didn't)
+    string const& error() const;
+
+    // Detaches -- unlinks the ring if the primary died with it linked
+    void takeOver();
+
+private:
+    string   _name;
+    int      _fd;
+    void*    _shared;
+    size_t   _size;
+    uint64_t _tail;    // records consumed
+    uint64_t _tick;    // of the latest record returned
+    bool     _hasHash; // ...whether it carries a state hash
+    uint64_t _hash;    // ...
+    string   _error;
+
+    bool isPrimaryGone() const;
+    void release();
+};
+
+
+} // tinyspace
+
+
+#endif // _TINYSPACE_REPLICA_HPP_
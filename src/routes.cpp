@@ -0,0 +1,155 @@
+// routes.cpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#include "routes.hpp"
+
+#include <algorithm>
+#include "models.hpp"
+
+
+namespace tinyspace {
+
+
+namespace {
+    uint16_t const NO_ROUTE = 0xFFFF;
+
+
+    void pointAt( sectors_t& sectors, Routes const* routes )
+    {
+        for ( auto& sectorRow : sectors )
+        {
+            for ( auto& sector : sectorRow ) sector.routes = routes;
+        }
+    }
+}
+
+
+Routes::Routes( sectors_t const& sectors )
+    : _colCount( sectors.empty() ? 0 : sectors[ 0 ].size() ),
+      _count( sectors.size() * _colCount ),
+      _nextHops()
+{
+    if ( _count >= NO_ROUTE )
+    {
+        _count = 0;
+    }
+    _nextHops.resize( _count * _count );
+
+    vector<uint16_t> queue;
+    queue.reserve( _count );
+    for ( size_t source = 0; source < _count; ++source )
+    {
+        search( sectors, source, queue );
+    }
+}
+
+
+Routes::~Routes()
+{}
+
+
+size_t Routes::sectorCount() const
+{
+    return _count;
+}
+
+
+size_t Routes::indexOf( Sector const& sector ) const
+{
+    return sector.rowcol.first * _colCount + sector.rowcol.second;
+}
+
+
+Sector* Routes::sectorAt( Sector const& from, size_t index ) const
+{
+    if ( ! _count )
+    {
+        return nullptr;
+    }
+
+    // walked gate by gate, so the sector is from's copy of the universe
+    Sector* sector = nullptr;
+    for ( Sector const* at = &from; indexOf( *at ) != index; at = sector )
+    {
+        Jumpgate* jumpgate = hopToward( *at, index );
+        if ( ! jumpgate )
+        {
+            return nullptr;
+        }
+        sector = jumpgate->target->sector;
+    }
+    return sector;
+}
+
+
+Jumpgate* Routes::nextJumpgate( Sector const& from, Sector const& to ) const
+{
+    if ( ! _count || &from == &to )
+    {
+        return nullptr;
+    }
+    return hopToward( from, indexOf( to ));
+}
+
+
+// Fills the 'source' row of the next-hop table
+void Routes::search( sectors_t const& sectors, size_t source, vector<uint16_t>& queue )
+{
+    uint16_t* row = &_nextHops[ source * _count ];
+
+    std::fill( row, row + _count, NO_ROUTE );
+    row[ source ] = static_cast<uint16_t>( source );
+
+    queue.clear();
+    queue.push_back( static_cast<uint16_t>( source ));
+    for ( size_t head = 0; head < queue.size(); ++head )
+    {
+        size_t current = queue[ head ];
+        for ( Jumpgate* jumpgate : sectors[ current / _colCount ][ current % _colCount ].jumpgates.all() )
+        {
+            size_t neighbor = indexOf( *jumpgate->target->sector );
+            if ( row[ neighbor ] == NO_ROUTE )
+            {
+                // first hop is the neighbor itself when leaving the source
+                row[ neighbor ] = current == source ? static_cast<uint16_t>( neighbor ) : row[ current ];
+                queue.push_back( static_cast<uint16_t>( neighbor ));
+            }
+        }
+    }
+}
+
+
+// Gate in 'from' one hop closer to sector index 'to'
+Jumpgate* Routes::hopToward( Sector const& from, size_t to ) const
+{
+    uint16_t next = _nextHops[ indexOf( from ) * _count + to ];
+    if ( next == NO_ROUTE )
+    {
+        return nullptr;
+    }
+
+    auto const& jumpgates = from.jumpgates;
+    if ( jumpgates.north && indexOf( *jumpgates.north->target->sector ) == next ) return jumpgates.north;
+    if ( jumpgates.east  && indexOf( *jumpgates.east->target->sector )  == next ) return jumpgates.east;
+    if ( jumpgates.south && indexOf( *jumpgates.south->target->sector ) == next ) return jumpgates.south;
+    if ( jumpgates.west  && indexOf( *jumpgates.west->target->sector )  == next ) return jumpgates.west;
+    return nullptr;
+}
+
+
+routes_ptr_t initRoutes( sectors_t& sectors )
+{
+    routes_ptr_t routes = std::make_shared<Routes const>( sectors );
+    pointAt( sectors, routes.get() );
+    return routes;
+}
+
+
+Jumpgate* nextJumpgate( Sector const& from, Sector const& to )
+{
+    return from.routes ? from.routes->nextJumpgate( from, to ) : nullptr;
+}
+
+
+} // tinyspace
@@ -0,0 +1,63 @@
+// routes.hpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#ifndef _TINYSPACE_ROUTES_HPP_
+#define _TINYSPACE_ROUTES_HPP_
+
+
+#include <cstdint>
+#include "types.hpp"
+
+
+namespace tinyspace {
+
+
+// All-pairs next-hop routing over the jumpgate graph.
+//
+// One BFS per sector fills a sectors x sectors table of uint16 next-hop sector
+// indices (2 bytes per pair -- 20KB for 10x10, 200MB for 100x100), so each hop
+// of a journey is an O(1) lookup. Universes over 65535 sectors are unrouted.
+//
+// A table is immutable once built, and keeps no pointers into the universe:
+// lookups go by sector index and the gates of the sector asked about. Each
+// sector points at its universe's table (Sector::routes), and the World holds
+// it -- clones share the original's (see world.hpp). Jumpgates never change
+// once the universe is built, so neither does the table.
+struct Routes
+{
+    // Searches every sector's routes
+    Routes( sectors_t const& sectors );
+    ~Routes();
+
+    size_t sectorCount() const;
+    size_t indexOf( Sector const& sector ) const;
+    // The sector at index in from's universe, reached along the route from it --
+    // nullptr if that's from itself or it's unreachable
+    Sector* sectorAt( Sector const& from, size_t index ) const;
+    // Jumpgate in 'from' one hop closer to 'to' -- nullptr when from == to or
+    // 'to' is unreachable
+    Jumpgate* nextJumpgate( Sector const& from, Sector const& to ) const;
+
+private:
+    size_t           _colCount;
+    size_t           _count;    // sectors routed -- 0 if unrouted
+    vector<uint16_t> _nextHops; // [ from * count + to ] -> next sector index
+
+    void search( sectors_t const& sectors, size_t source, vector<uint16_t>& queue );
+    Jumpgate* hopToward( Sector const& from, size_t to ) const;
+};
+
+
+// Builds the table from the sectors' current jumpgates and points them at it
+routes_ptr_t initRoutes( sectors_t& sectors );
+
+// Jumpgate in 'from' one hop closer to 'to' by from's table -- nullptr
+// without one
+Jumpgate* nextJumpgate( Sector const& from, Sector const& to );
+
+
+} // tinyspace
+
+
+#endif // _TINYSPACE_ROUTES_HPP_
@@ -0,0 +1,202 @@
+// schedule.cpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#include "schedule.hpp"
+
+#include <algorithm>
+#include "constants.hpp"
+#include "models.hpp"
+
+
+namespace tinyspace {
+
+
+TimingWheel::TimingWheel( double resolution, double time )
+    : _resolution( resolution ), _tick( 0 ), _size( 0 ), _slots(), _overflow()
+{
+    _tick = tickOf( time );
+}
+
+
+uint64_t TimingWheel::tickOf( double time ) const
+{
+    return time > 0.0 ? static_cast<uint64_t>( time / _resolution ) : 0;
+}
+
+
+void TimingWheel::schedule( Timer const& timer )
+{
+    place( timer );
+    ++_size;
+}
+
+
+void TimingWheel::place( Timer const& timer )
+{
+    // overdue timers fire from the current slot
+    uint64_t tick = std::max( tickOf( timer.time ), _tick );
+
+    // lowest level whose span still contains both the current tick and the deadline
+    for ( unsigned int level = 0; level < WHEEL_LEVELS; ++level )
+    {
+        unsigned int shift = ( level + 1 ) * WHEEL_BITS;
+        if (( tick >> shift ) == ( _tick >> shift ))
+        {
+            _slots[ level ][ ( tick >> ( level * WHEEL_BITS )) & ( WHEEL_SLOTS - 1 ) ].push_back( timer );
+            return;
+        }
+    }
+    _overflow.push_back( timer );
+}
+
+
+void TimingWheel::cascade()
+{
+    if ( _tick & ( WHEEL_SLOTS - 1 ))
+    {
+        return; // level 0 hasn't wrapped
+    }
+
+    // highest level whose index wrapped along with the ones below it
+    unsigned int top = 1;
+    while ( top < WHEEL_LEVELS && (( _tick >> ( top * WHEEL_BITS )) & ( WHEEL_SLOTS - 1 )) == 0 )
+    {
+        ++top;
+    }
+
+    timers_t pending;
+    if ( top == WHEEL_LEVELS )
+    {
+        pending.swap( _overflow );
+        for ( auto& timer : pending ) place( timer );
+        top = WHEEL_LEVELS - 1;
+    }
+    for ( unsigned int level = top; level > 0; --level )
+    {
+        pending.clear();
+        pending.swap( _slots[ level ][ ( _tick >> ( level * WHEEL_BITS )) & ( WHEEL_SLOTS - 1 ) ] );
+        for ( auto& timer : pending ) place( timer );
+    }
+}
+
+
+void TimingWheel::advance( double time, timers_t& expired )
+{
+    uint64_t target = tickOf( time );
+
+    if ( ! _size )
+    {
+        // nothing to cascade -- skip straight to the target
+        _tick = std::max( _tick, target );
+        return;
+    }
+
+    size_t first = expired.size();
+    while ( true )
+    {
+        auto& slot = _slots[ 0 ][ _tick & ( WHEEL_SLOTS - 1 ) ];
+        if ( ! slot.empty() )
+        {
+            // the target slot can still hold timers due later within it
+            auto due = std::stable_partition( slot.begin(), slot.end(),
+                [ time ]( Timer const& timer ) { return timer.time <= time; } );
+            expired.insert( expired.end(), slot.begin(), due );
+            slot.erase( slot.begin(), due );
+        }
+        if ( _tick >= target )
+        {
+            break;
+        }
+        ++_tick;
+        cascade();
+    }
+    _size -= expired.size() - first;
+
+    std::stable_sort( expired.begin() + first, expired.end(),
+        []( Timer const& a, Timer const& b ) { return a.time < b.time; } );
+}
+
+
+size_t TimingWheel::size() const
+{
+    return _size;
+}
+
+
+void TimingWheel::relocateShips( std::function<Ship*( Ship* )> const& relocate )
+{
+    for ( auto& level : _slots )
+    {
+        for ( auto& slot : level )
+        {
+            for ( auto& timer : slot ) timer.ship = relocate( timer.ship );
+        }
+    }
+    for ( auto& timer : _overflow ) timer.ship = relocate( timer.ship );
+}
+
+
+Schedule::Schedule( bool kinetic, bool statisticalCombat, bool doubleBuffered )
+    : time( 0.0 ), kinetic( kinetic ), statisticalCombat( statisticalCombat ), coarseCombat( false ), doubleBuffered( doubleBuffered ),
+      arrivals(), timers( TIMER_RESOLUTION ), expired()
+{}
+
+
+Schedule::~Schedule()
+{}
+
+
+void Schedule::advance( double delta )
+{
+    time += delta;
+    expired.clear();
+    timers.advance( time, expired );
+}
+
+
+void Schedule::addTimer( Ship& ship, TimerType type, double time )
+{
+    timers.schedule( { time, &ship, type } );
+}
+
+
+void Schedule::relocateShips( std::function<Ship*( Ship* )> const& relocate )
+{
+    timers.relocateShips( relocate );
+    for ( auto& timer : expired ) timer.ship = relocate( timer.ship );
+
+    vector<Arrival> pending;
+    pending.reserve( arrivals.size() );
+    while ( ! arrivals.empty() )
+    {
+        pending.push_back( arrivals.top() );
+        arrivals.pop();
+    }
+    for ( auto& arrival : pending )
+    {
+        arrival.ship = relocate( arrival.ship );
+        arrivals.push( arrival );
+    }
+}
+
+
+void Schedule::depart( Ship& ship, double time )
+{
+    position_t destPos  = ship.destination->currentPosition();
+    direction_t leg     = destPos - ship.position;
+    distance_t distance = leg.magnitude();
+
+    if ( distance )
+    {
+        ship.direction = leg / distance;
+    }
+    ship.origin    = ship.position;
+    ship.departure = time;
+    ship.arrival   = time + distance / ship.speed;
+
+    arrivals.push( { ship.arrival, ship.id, &ship } );
+}
+
+
+} // tinyspace
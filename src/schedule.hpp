@@ -0,0 +1,118 @@
+// schedule.hpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#ifndef _TINYSPACE_SCHEDULE_HPP_
+#define _TINYSPACE_SCHEDULE_HPP_
+
+
+#include <cstdint>
+#include "types.hpp"
+
+
+namespace tinyspace {
+
+
+enum TimerType : unsigned int
+{
+    TimerType_NONE,
+    TimerType_Undock,
+    TimerType_Respawn,
+    TimerType_END
+};
+
+
+// A ship deadline -- stale timers (the ship's deadline moved on, or the ship
+// was respawned) are skipped by the handler when they fire
+struct Timer
+{
+    double    time; // sim time (seconds)
+    Ship*     ship;
+    TimerType type;
+};
+
+typedef vector<Timer> timers_t;
+
+
+// Queued kinetic arrival. Ties go by the ship's id when queued rather than
+// its address, so the order survives ship storage reorders (see locality.hpp)
+struct Arrival
+{
+    double time; // sim time (seconds)
+    id_t   id;
+    Ship*  ship;
+
+    bool operator >( Arrival const& other ) const
+    {
+        return time != other.time ? time > other.time : id > other.id;
+    }
+};
+
+typedef std::priority_queue<Arrival, vector<Arrival>, std::greater<Arrival>> arrival_queue_t;
+
+
+// Hierarchical timing wheel -- each level has WHEEL_SLOTS slots, each slot
+// spanning WHEEL_SLOTS times the one below it. Timers cascade down a level
+// when the wheel reaches their slot, so each tick only touches the slots it
+// passes and the timers that actually fire.
+class TimingWheel
+{
+public:
+    TimingWheel( double resolution, double time=0.0 );
+
+    void schedule( Timer const& timer );
+    // Appends timers due at or before the given sim time, earliest first
+    void advance( double time, timers_t& expired );
+    size_t size() const;
+
+    // Rewrites every pending timer's ship -- slots and order are unchanged
+    void relocateShips( std::function<Ship*( Ship* )> const& relocate );
+
+private:
+    static unsigned int const WHEEL_BITS   = 6;
+    static unsigned int const WHEEL_SLOTS  = 1 << WHEEL_BITS;
+    static unsigned int const WHEEL_LEVELS = 4;
+
+    double   _resolution; // seconds per level 0 slot
+    uint64_t _tick;       // current level 0 tick
+    size_t   _size;
+    timers_t _slots[ WHEEL_LEVELS ][ WHEEL_SLOTS ];
+    timers_t _overflow;   // beyond the top level -- re-placed when it wraps
+
+    uint64_t tickOf( double time ) const;
+    void place( Timer const& timer );
+    void cascade();
+};
+
+
+// Sim clock and scheduled events shared by the tick phases
+struct Schedule
+{
+    double          time;              // sim time (seconds)
+    bool            kinetic;           // ships move analytically between scheduled arrivals
+    bool            statisticalCombat; // sectors below full detail resolve combat in aggregate
+    bool            coarseCombat;      // only watched sectors resolve combat shot by shot (load shedding)
+    bool            doubleBuffered;    // combat sees other ships' hull and docking as the tick began (pingpong.hpp)
+    arrival_queue_t arrivals;          // kinetic mode only -- earliest arrival first
+    TimingWheel     timers;            // dock and respawn deadlines
+    timers_t        expired;           // timers fired by the latest advance, earliest first
+
+    Schedule( bool kinetic=false, bool statisticalCombat=true, bool doubleBuffered=false );
+    ~Schedule();
+
+    // Move the clock forward and collect the timers that fired
+    void advance( double delta );
+    void addTimer( Ship& ship, TimerType type, double time );
+
+    // Points queued arrivals and timers at ships' new records (see locality.hpp)
+    void relocateShips( std::function<Ship*( Ship* )> const& relocate );
+
+    // Start a ship on a straight leg toward its destination and queue its arrival
+    void depart( Ship& ship, double time );
+};
+
+
+} // tinyspace
+
+
+#endif // _TINYSPACE_SCHEDULE_HPP_
@@ -0,0 +1,129 @@
+// statehash.cpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#include "statehash.hpp"
+
+#include "constants.hpp"
+
+
+namespace tinyspace {
+
+
+namespace {
+
+uint64_t const NO_INDEX = ~0ull;
+
+// splitmix64 finalizer
+inline uint64_t scramble( uint64_t x )
+{
+    x = ( x ^ ( x >> 30 )) * 0xBF58476D1CE4E5B9ull;
+    x = ( x ^ ( x >> 27 )) * 0x94D049BB133111EBull;
+    return x ^ ( x >> 31 );
+}
+
+inline uint64_t shipHandle( ships_t const& ships, ShipLocality const& locality, target_ptr_t target )
+{
+    return target ? locality.handleOf( ships, static_cast<Ship const*>( target )).slot : NO_INDEX;
+}
+
+inline uint64_t sectorIndex( Sector const* sector )
+{
+    return sector ? ( sector->rowcol.first << 32 ) | sector->rowcol.second : NO_INDEX;
+}
+
+} // anonymous
+
+
+StateHash::StateHash()
+    : value( 0xCBF29CE484222325ull )
+{}
+
+
+StateHash::~StateHash()
+{}
+
+
+void StateHash::add( uint64_t word )
+{
+    value = ( value ^ scramble( word )) * 0x100000001B3ull;
+}
+
+
+void StateHash::add( double value )
+{
+    uint64_t bits;
+    memcpy( &bits, &value, sizeof( bits ));
+    add( bits );
+}
+
+
+void StateHash::add( float value )
+{
+    uint32_t bits;
+    memcpy( &bits, &value, sizeof( bits ));
+    add( static_cast<uint64_t>( bits ));
+}
+
+
+uint64_t hashState( Schedule const& schedule, sectors_t const& sectors, ships_t const& ships,
+    ShipLocality const& locality )
+{
+    StateHash hash;
+    hash.add( schedule.time );
+
+    for ( size_t slot = 0; slot < ships.size(); ++slot )
+    {
+        Ship const& ship = locality.resolve( ships, { slot } );
+        hash.add( sectorIndex( ship.sector ));
+        hash.add( static_cast<uint64_t>( ship.type )
+                | static_cast<uint64_t>( ship.faction ) << 8
+                | static_cast<uint64_t>( ship.docked )  << 16
+                | static_cast<uint64_t>( ship.parked )  << 17 );
+        if ( ship.parked )
+        {
+            continue; // pooled records are rebuilt when materialized
+        }
+        hash.add( ship.position.x );
+        hash.add( ship.position.y );
+        hash.add( ship.direction.x );
+        hash.add( ship.direction.y );
+        hash.add( ship.origin.x );
+        hash.add( ship.origin.y );
+        hash.add( ship.departure );
+        hash.add( static_cast<uint64_t>( ship.currentHull ));
+        hash.add( ship.timeoutAt );
+        hash.add( shipHandle( ships, locality, ship.target ));
+        for ( auto& weapon : ship.weapons() )
+        {
+            hash.add( shipHandle( ships, locality, weapon->target ));
+            hash.add( weapon->readyAt );
+        }
+        for ( auto& turret : ship.turrets() )
+        {
+            hash.add( shipHandle( ships, locality, turret->target ));
+            hash.add( turret->readyAt );
+        }
+    }
+
+    for ( auto& sectorRow : sectors )
+    {
+        for ( auto& sector : sectorRow )
+        {
+            if ( ! sector.traffic->total() )
+            {
+                continue;
+            }
+            hash.add( sectorIndex( &sector ));
+            for ( auto& factionCounts : sector.traffic->counts )
+            {
+                for ( auto count : factionCounts ) hash.add( static_cast<uint64_t>( count ));
+            }
+        }
+    }
+
+    return hash.value;
+}
+
+
+} // tinyspace
@@ -0,0 +1,57 @@
+// statehash.hpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#ifndef _TINYSPACE_STATEHASH_HPP_
+#define _TINYSPACE_STATEHASH_HPP_
+
+
+#include <cstdint>
+#include <cstring>
+#include "locality.hpp"
+#include "models.hpp"
+#include "schedule.hpp"
+#include "types.hpp"
+
+
+namespace tinyspace {
+
+
+// Streaming 64-bit hash -- each word is scrambled and folded in, so field
+// order matters and a single flipped bit changes the result
+struct StateHash
+{
+    uint64_t value;
+
+    StateHash();
+    ~StateHash();
+
+    void add( uint64_t word );
+
+    // Hashes the exact bits, so -0.0 and 0.0 (or any rounding difference) differ
+    void add( double value );
+    void add( float value );
+};
+
+
+// Hashes the simulation state: the sim time, and per ship its sector,
+// lifecycle flags, position, direction, trajectory, hull, timeout, and its
+// own and its weapons' targets, plus each sector's traffic counts. Ships go
+// in handle order and targets by handle, so the hash doesn't depend on where
+// records are stored (see locality.hpp) or how ids were handed out. Parked
+// ships contribute only their flags. Linear in ships and sectors, with no
+// allocation.
+//
+// Each call rescans the world rather than keeping a running hash updated as
+// fields are written: hashed fields are written all over (actions, schedule,
+// traffic, locality), and a check of those writes shouldn't go through them.
+// About 20us at the default 500 ships -- every tick, that's twice the tick
+// itself, so CI hashes every 100 ticks or so.
+uint64_t hashState( Schedule const& schedule, sectors_t const& sectors, ships_t const& ships,
+    ShipLocality const& locality );
+
+
+} // tinyspace
+
+
+#endif // _TINYSPACE_STATEHASH_HPP_
@@ -0,0 +1,233 @@
+// traffic.cpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#include "traffic.hpp"
+
+#include <algorithm>
+#include "constants.hpp"
+#include "init.hpp"
+#include "models.hpp"
+#include "rand.hpp"
+#include "schedule.hpp"
+
+
+namespace tinyspace {
+
+
+Traffic::Traffic()
+    : _pool(), _transfers()
+{}
+
+
+Traffic::~Traffic()
+{}
+
+
+size_t Traffic::parkedCount() const
+{
+    return _pool.size();
+}
+
+
+void Traffic::relocateShips( std::function<Ship*( Ship* )> const& relocate )
+{
+    for ( auto& ship : _pool ) ship = relocate( ship );
+}
+
+
+void Traffic::park( Sector& sector, Ship const* playerShip, double time )
+{
+    // dead ships keep their records until they respawn -- partitions, not
+    // the pointer-ordered ships set, so parking order doesn't depend on
+    // where records are stored
+    ship_ptrs_t parking;
+    for ( ShipState state : { ShipState_Flying, ShipState_Docked } )
+    {
+        for ( size_t faction = 0; faction < ShipFaction_END; ++faction )
+        {
+            for ( Ship* ship : sector.stateShips( state, static_cast<ShipFaction>( faction )))
+            {
+                if ( ship != playerShip ) parking.push_back( ship );
+            }
+        }
+    }
+
+    for ( Ship* ship : parking )
+    {
+        ++sector.traffic.edit().counts[ ship->faction ][ ship->type ];
+        sector.removeShip( ship );
+
+        ship->stop( time );
+        ship->sector    = nullptr;
+        ship->parked    = true;
+        ship->docked    = false; // stale dock timer
+        ship->timeoutAt = 0.0;
+        ship->journey   = nullptr;
+        ship->target    = nullptr;
+        // materialize re-arms and renames -- only the fixed-size record stays
+        ship->destination = nullptr;
+        ship->code        = string();
+        ship->name        = string();
+        ship->setWeapons( {} );
+        ship->setTurrets( {} );
+        _pool.push_back( ship );
+    }
+}
+
+
+void Traffic::flow( Sector& sector, bool useJumpgates )
+{
+    auto& traffic  = sector.traffic.edit();
+    auto jumpgates = sector.jumpgates.all();
+    if ( ! useJumpgates || jumpgates.empty() )
+    {
+        return; // ships never leave a sector without jumpgates
+    }
+
+    // per-leg destination chances, as randDestination picks them
+    float destinations  = sector.stations.size() + jumpgates.size();
+    float gateChance    = ( 1.f - MISC_DESTINATION_CHANCE ) * jumpgates.size() / destinations;
+    float stationChance = ( 1.f - MISC_DESTINATION_CHANCE ) * sector.stations.size() / destinations;
+    distance_t leg      = TRAFFIC_LEG_LENGTH * ( sector.size.x + sector.size.y ) / 2;
+
+    for ( size_t faction = 0; faction < ShipFaction_END; ++faction )
+    {
+        for ( size_t type = 0; type < ShipType_END; ++type )
+        {
+            auto& count = traffic.counts[ faction ][ type ];
+            if ( ! count )
+            {
+                continue;
+            }
+            double legTime  = leg / shipSpeed( static_cast<ShipType>( type )) + stationChance * DOCK_TIME;
+            double expected = count * gateChance * traffic.delta / legTime;
+            auto   leaving  = static_cast<unsigned int>( expected );
+            if ( randFloat() < expected - leaving )
+            {
+                ++leaving;
+            }
+            leaving = std::min( leaving, count );
+            count  -= leaving;
+            while ( leaving-- )
+            {
+                Jumpgate* jumpgate = jumpgates[ randInt() % jumpgates.size() ];
+                _transfers.push_back( { jumpgate->target,
+                                        static_cast<ShipFaction>( faction ),
+                                        static_cast<ShipType>( type ) } );
+            }
+        }
+    }
+}
+
+
+void Traffic::materialize(
+    Schedule& schedule,
+    Sector& sector,
+    ShipFaction faction,
+    ShipType type,
+    Jumpgate* jumpgate,
+    bool useJumpgates )
+{
+    if ( _pool.empty() )
+    {
+        return;
+    }
+    Ship& ship = *_pool.back();
+    _pool.pop_back();
+
+    // arrivals come through their gate, others are somewhere along a leg
+    location_ptrs_t excludes;
+    position_t pos;
+    if ( jumpgate )
+    {
+        pos = jumpgate->position;
+        excludes.push_back( jumpgate );
+    }
+    else
+    {
+        pos = randPosition( sector.size, 0.1f );
+    }
+    auto dest = randDestination( sector, useJumpgates, MISC_DESTINATION_CHANCE, &excludes );
+    auto dir  = ( dest->position - pos ).normalized();
+
+    ship = Ship( type, shipHull( type ), randCode(), randName( type ), &sector, pos, dir, shipSpeed( type ), dest );
+    ship.faction = faction;
+    armShip( ship );
+
+    if ( schedule.kinetic )
+    {
+        schedule.depart( ship, schedule.time );
+    }
+    sector.addShip( &ship );
+}
+
+
+void Traffic::update(
+    Schedule& schedule,
+    sectors_t& sectors,
+    LevelOfDetail const& lod,
+    Ship const* playerShip,
+    double delta,
+    bool useJumpgates )
+{
+    for ( Sector* sector : lod.dormant )
+    {
+        park( *sector, playerShip, schedule.time );
+        sector->traffic.edit().delta = 0.0;
+    }
+
+    for ( Sector* sector : lod.awoken )
+    {
+        for ( size_t faction = 0; faction < ShipFaction_END; ++faction )
+        {
+            for ( size_t type = 0; type < ShipType_END; ++type )
+            {
+                auto& count = sector->traffic.edit().counts[ faction ][ type ];
+                for ( ; count; --count )
+                {
+                    materialize( schedule, *sector, static_cast<ShipFaction>( faction ),
+                        static_cast<ShipType>( type ), nullptr, useJumpgates );
+                }
+            }
+        }
+    }
+
+    // Flow steps are staggered across the interval. Ships that wandered or
+    // respawned into the sector since the last step are parked first.
+    _transfers.clear();
+    size_t i = 0;
+    for ( auto& sectorRow : sectors )
+    {
+        for ( auto& sector : sectorRow )
+        {
+            if ( sector.lod.tier == LodTier_Dormant )
+            {
+                sector.traffic.edit().delta += delta;
+                if (( lod.tick + i ) % TRAFFIC_INTERVAL == 0 )
+                {
+                    park( sector, playerShip, schedule.time );
+                    flow( sector, useJumpgates );
+                    sector.traffic.edit().delta = 0.0;
+                }
+            }
+            ++i;
+        }
+    }
+
+    for ( auto& transfer : _transfers )
+    {
+        Sector& sector = *transfer.jumpgate->sector;
+        if ( sector.lod.tier == LodTier_Dormant )
+        {
+            ++sector.traffic.edit().counts[ transfer.faction ][ transfer.type ];
+        }
+        else
+        {
+            materialize( schedule, sector, transfer.faction, transfer.type, transfer.jumpgate, useJumpgates );
+        }
+    }
+}
+
+
+} // tinyspace
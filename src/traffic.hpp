@@ -0,0 +1,70 @@
+// traffic.hpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#ifndef _TINYSPACE_TRAFFIC_HPP_
+#define _TINYSPACE_TRAFFIC_HPP_
+
+
+#include "lod.hpp"
+#include "types.hpp"
+
+
+namespace tinyspace {
+
+
+// Aggregate traffic for dormant sectors.
+//
+// Live ships in a dormant sector are parked: each becomes a count by faction
+// and type in the sector's SectorTraffic, and its record goes to the pool.
+// Every TRAFFIC_INTERVAL ticks a dormant sector sends counts through its
+// jumpgates at the rate randDestination would -- the chance a leg ends at a
+// gate (stations, gates and MISC_DESTINATION_CHANCE) over the expected leg
+// and docking time. Counts reaching an observed sector, and every count of a
+// sector that wakes up, are materialized from the pool as fresh ships.
+// Journeys, hull damage and identities don't survive parking.
+//
+// Parking saves simulation, not storage: a pooled record gives up its
+// weapons, name and destination, but keeps its slot in ships_t -- handles,
+// partitions and the pool point into the array, so it never shrinks.
+// Memory stays proportional to the total ship count, sizeof( Ship ) each.
+struct Traffic
+{
+    Traffic();
+    ~Traffic();
+
+    void update(
+        Schedule& schedule,
+        sectors_t& sectors,
+        LevelOfDetail const& lod,
+        Ship const* playerShip,
+        double delta, // seconds
+        bool useJumpgates );
+
+    size_t parkedCount() const;
+
+    // Points pooled records at their new storage (see locality.hpp)
+    void relocateShips( std::function<Ship*( Ship* )> const& relocate );
+
+private:
+    struct Transfer
+    {
+        Jumpgate*   jumpgate; // arrival gate
+        ShipFaction faction;
+        ShipType    type;
+    };
+
+    ship_ptrs_t      _pool;      // parked ship records, one per count
+    vector<Transfer> _transfers; // flow scratch
+
+    void park( Sector& sector, Ship const* playerShip, double time );
+    void flow( Sector& sector, bool useJumpgates );
+    void materialize( Schedule& schedule, Sector& sector, ShipFaction faction, ShipType type,
+        Jumpgate* jumpgate, bool useJumpgates );
+};
+
+
+} // tinyspace
+
+
+#endif // _TINYSPACE_TRAFFIC_HPP_
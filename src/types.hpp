@@ -6,9 +6,12 @@
 #define _TINYSPACE_TYPES_HPP_
 
 
+#include <functional>
 #include <memory>
+#include <queue>
 #include <set>
 #include <vector>
+#include "opt/persistent.hpp"
 #include "vector2.hpp"
 
 
@@ -24,12 +27,15 @@ struct Destination;
 struct HasIDAndSectorAndPosition;
 struct HasSectorAndPosition;
 struct Jumpgate;
+struct Routes;
+struct Schedule;
 struct Sector;
 struct Ship;
 struct Station;
 struct Weapon;
 
 enum IdType : unsigned int;
+enum LodTier : unsigned int;
 enum ShipFaction : unsigned int;
 enum ShipType : unsigned int;
 enum WeaponPosition : int;
@@ -51,6 +57,7 @@ typedef float           distance_t;
 // Class-specific types
 typedef shared_ptr<Destination>    destination_ptr_t;
 typedef shared_ptr<Weapon>         weapon_ptr_t;
+typedef shared_ptr<Routes const>   routes_ptr_t;
 typedef HasSectorAndPosition*      location_ptr_t;
 typedef HasIDAndSectorAndPosition* target_ptr_t;
 
@@ -70,6 +77,11 @@ typedef vector<location_ptr_t>     location_ptrs_t;
 typedef set<Station*>              station_ptrs_set_t;
 typedef set<Ship*>                 ship_ptrs_set_t;
 
+// Structure-sharing copies (opt/persistent.hpp) -- snapshots in O(1)
+typedef PersistentSet<Ship*>          ship_ptrs_pset_t;
+typedef PersistentVector<weapon_ptr_t> weapon_ptrs_pvec_t;
+
+
 
 } // tinyspace
 
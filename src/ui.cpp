@@ -4,6 +4,7 @@
 
 #include "ui.hpp"
 
+#include <algorithm>
 #include <iomanip>
 #include <map>
 #include <sstream>
@@ -53,7 +54,7 @@ string shipString( Ship const& ship, bool useColor, unsigned int color )
     {
         os << beginColorString( color );
     }
-    if ( ship.code.size() )
+    if ( ship.code->size() )
     {
         os << /*" code:"*/ " " << ship.code;
     }
@@ -88,7 +89,7 @@ string shipString( Ship const& ship, bool useColor, unsigned int color )
     os << /*" class:"*/ " " << paddedShipClass( ship.type );
     if ( ship.target && ship.sector == ship.target->sector )
     {
-        if ( auto target = dynamic_cast<Ship*>( ship.target ))
+        if ( auto target = dynamic_cast<Ship*>( ship.target() ))
         {
             os << " -> "
                << beginColorString( target->faction == ShipFaction_Player ? PLAYER_COLOR
@@ -132,7 +133,7 @@ string shipString( Ship const& ship, bool useColor, unsigned int color )
 vector<string> createSectorShipsList( Sector& sector, Ship* playerShip, bool const useColor )
 {
     vector<string> shipsList;
-    for ( auto ship : sector.ships )
+    for ( auto ship : sector.ships() )
     {
         if ( ship->docked ) continue;
         std::ostringstream os;
@@ -165,7 +166,7 @@ vector<string> createSectorShipsList( Sector& sector, Ship* playerShip, bool con
 }
 
 
-vector<string> createSectorMap( Sector& sector, Ship* playerShip, bool useColor )
+vector<string> createSectorMap( Sector& sector, Ship* playerShip, bool useColor, double time )
 {
     static string leftPadding( SECTOR_MAP_LEFT_PADDING, ' ' );
     vector<string> sectorMap;
@@ -185,7 +186,7 @@ vector<string> createSectorMap( Sector& sector, Ship* playerShip, bool useColor
         std::ostringstream os;
         os << leftPadding << "+-[ "
            << colorString( PLAYER_COLOR, sector.name, useColor )
-           << " ]" << string((( sector.size.x+1 ) * 3 ) - sector.name.size() - 5, '-' )
+           << " ]" << string((( sector.size.x+1 ) * 3 ) - sector.name->size() - 5, '-' )
            << '+';
         sectorMap.push_back( os.str() );
     }
@@ -217,7 +218,7 @@ vector<string> createSectorMap( Sector& sector, Ship* playerShip, bool useColor
     };
 
     // ships
-    for ( auto ship : sector.ships )
+    for ( auto ship : sector.ships() )
     {
         bool isPlayerShip    = ship == playerShip;
         bool isPlayerFaction = ship->faction == ShipFaction_Player;
@@ -246,7 +247,7 @@ vector<string> createSectorMap( Sector& sector, Ship* playerShip, bool useColor
             string shipStr = ".";
             if ( isPlayerShip )
             {
-                auto& dir = ship->direction;
+                auto dir = ship->direction();
                 auto dirMax = std::max( dir.y, 0.0f );
                 shipStr = "v";
                 if ( dir.x > 0 && dir.x > dirMax )
@@ -329,7 +330,7 @@ vector<string> createSectorMap( Sector& sector, Ship* playerShip, bool useColor
     if ( playerShip && playerShip->currentHull <= 0 )
     {
         char respawn[20];
-        snprintf( respawn, 20, "|  respawn in %2d  |", static_cast<int>( playerShip->timeout ));
+        snprintf( respawn, 20, "|  respawn in %2d  |", static_cast<int>( std::max( 0.0, playerShip->timeoutAt - time )));
         vector<string> killscreen = {
             "+-----------------+",
             "| you were killed |",
@@ -392,9 +393,10 @@ vector<string> createGlobalMap( sectors_t const& sectors, Ship* playerShip, bool
                 playerSectorIndex = { i, j };
             }
 
-            size_t shipCount = sector.ships.size();
-            bool hasPlayerProperty = false;
-            for ( auto ship : sector.ships )
+            // dormant sectors hold most of their ships as traffic counts
+            size_t shipCount = sector.ships->size() + sector.traffic->total();
+            bool hasPlayerProperty = sector.traffic->total( ShipFaction_Player ) > 0;
+            for ( auto ship : sector.ships() )
             {
                 if ( ship->currentHull <= 0.f )
                 {
@@ -462,10 +464,11 @@ void updateDisplay(
     std::ostream& os,
     sectors_t& sectors,
     Ship& playerShip,
-    bool const useColor )
+    bool const useColor,
+    double time )
 {
     auto shipsList = createSectorShipsList( *playerShip.sector, &playerShip, useColor );
-    auto sectorMap = createSectorMap( *playerShip.sector, &playerShip, useColor );
+    auto sectorMap = createSectorMap( *playerShip.sector, &playerShip, useColor, time );
     auto globalMap = createGlobalMap( sectors, &playerShip, useColor );
     
     for ( size_t i = 0; i<50; ++i ) os << std::endl;
@@ -47,14 +47,15 @@ string colorString(
 string shipString( Ship const& ship, bool useColor=false, unsigned int color=0 );
 
 vector<string> createSectorShipsList( Sector& sector, Ship* playerShip, bool const useColor );
-vector<string> createSectorMap( Sector& sector, Ship* playerShip, bool useColor );
+vector<string> createSectorMap( Sector& sector, Ship* playerShip, bool useColor, double time );
 vector<string> createGlobalMap( sectors_t const& sectors, Ship* playerShip, bool const useColor );
 
 void updateDisplay(
     std::ostream& os,
     sectors_t& sectors,
     Ship& playerShip,
-    bool const useColor );
+    bool const useColor,
+    double time ); // sim time (seconds)
 
 
 } // tinyspace
@@ -20,9 +20,9 @@ struct Vector2
 
     Vector2();
     Vector2( T const& x, T const& y );
-    Vector2( Vector2<T,U> const& o );
+    Vector2( Vector2<T,U> const& o ) = default; // trivially copyable for plain T
 
-    Vector2<T,U>& operator =( Vector2<T,U> const& o );
+    Vector2<T,U>& operator =( Vector2<T,U> const& o ) = default;
 
     Vector2<T,U> operator +( Vector2<T,U> const& o ) const;
     Vector2<T,U> operator -( Vector2<T,U> const& o ) const;
@@ -35,6 +35,7 @@ struct Vector2
     Vector2<T,U> operator -( U u ) const;
 
     U magnitude() const;
+    U magnitudeSquared() const; // no sqrt -- for distance comparisons
     Vector2<T,U> normalized() const;
 
     Vector2<T,U> port() const;      // relative left
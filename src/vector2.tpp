@@ -33,22 +33,6 @@ inline Vector2<T,U>::Vector2( T const& x, T const& y )
 {}
 
 
-template <typename T, typename U>
-inline Vector2<T,U>::Vector2( Vector2<T,U> const& o )
-    : x( o.x )
-    , y( o.y )
-{}
-
-
-template <typename T, typename U>
-inline Vector2<T,U>& Vector2<T,U>::operator =( Vector2<T,U> const& o )
-{
-    x = o.x;
-    y = o.y;
-    return *this;
-}
-
-
 template <typename T, typename U>
 inline Vector2<T,U> Vector2<T,U>::operator +( Vector2<T,U> const& o ) const
 {
@@ -105,6 +89,13 @@ inline U Vector2<T,U>::magnitude() const
 }
 
 
+template <typename T, typename U>
+inline U Vector2<T,U>::magnitudeSquared() const
+{
+    return x*x + y*y;
+}
+
+
 template <typename T, typename U>
 inline Vector2<T,U> Vector2<T,U>::normalized() const
 {
@@ -0,0 +1,237 @@
+// world.cpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#include "world.hpp"
+
+#include <chrono>
+#include <functional>
+#include "actions.hpp"
+#include "init.hpp"
+#include "opt/saveable.hpp"
+#include "rand.hpp"
+#include "routes.hpp"
+
+
+namespace tinyspace {
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+
+namespace {
+
+// Puts a world's random stream and id counter on the calling thread while
+// it steps, and hands them back after
+struct Stepping
+{
+    Stepping( uint64_t& stream, id_t& lastId, bool isClone )
+        : _stream( stream ), _lastId( lastId ),
+          _threadStream( randStream() ), _threadLastId( HasID::lastId() ), _detached( detachedWrites )
+    {
+        setRandStream( stream );
+        HasID::setLastId( lastId );
+        detachedWrites = _detached || isClone;
+    }
+
+    ~Stepping()
+    {
+        _stream = randStream();
+        _lastId = HasID::lastId();
+        setRandStream( _threadStream );
+        HasID::setLastId( _threadLastId );
+        detachedWrites = _detached;
+    }
+
+private:
+    uint64_t& _stream;
+    id_t&     _lastId;
+    uint64_t  _threadStream;
+    id_t      _threadLastId;
+    bool      _detached;
+};
+
+
+template <typename T>
+T* rebase( T* p, vector<T> const& from, vector<T>& to )
+{
+    return p ? &to[ p - from.data() ] : nullptr;
+}
+
+} // anonymous
+
+
+World::World( ReplayConfig const& config, size_t shipCount, v2size_t const& bounds, dimensions_t const& sectorSize )
+    : config( config ),
+      sectors( initSectors( bounds, sectorSize )),
+      jumpgates( initJumpgates( sectors, config.useJumpgates )),
+      routes( initRoutes( sectors )),
+      stations( initStations( sectors )),
+      ships( initShips( shipCount, sectors, config.useJumpgates )),
+      locality( ships.size() ),
+      playerHandle{ 0 },
+      player( &locality.resolve( ships, playerHandle )),
+      schedule( config.useKinetic, ! config.useShotCombat, config.useDoubleBuffer ),
+      lod(),
+      traffic(),
+      isClone( false )
+{
+    if ( schedule.kinetic )
+    {
+        for ( auto& ship : ships ) schedule.depart( ship, schedule.time );
+    }
+    _stream = randStream();
+    _lastId = HasID::lastId();
+}
+
+
+World::World( World const& o, uint64_t stream )
+    : config( o.config ),
+      sectors( o.sectors ),
+      jumpgates( o.jumpgates ),
+      routes( o.routes ),
+      stations( o.stations ),
+      ships( o.ships ),
+      locality( o.locality ),
+      playerHandle( o.playerHandle ),
+      player( &locality.resolve( ships, playerHandle )),
+      schedule( o.schedule ),
+      lod( o.lod ),
+      traffic( o.traffic ),
+      isClone( true ),
+      _stream( stream ),
+      _lastId( o._lastId )
+{
+    config.useDoubleBuffer  = false;
+    schedule.doubleBuffered = false;
+    rewire( o );
+}
+
+
+World::~World()
+{}
+
+
+std::unique_ptr<World> World::clone() const
+{
+    DetachedWrites detached;
+    return std::unique_ptr<World>( new World( *this, _stream ));
+}
+
+
+std::unique_ptr<World> World::clone( uint64_t seed ) const
+{
+    DetachedWrites detached;
+    return std::unique_ptr<World>( new World( *this, seedStream( seed )));
+}
+
+
+void World::advance( double delta, double* phases )
+{
+    Stepping stepping( _stream, _lastId, isClone );
+
+    // Runs a tick phase and records its time in phases[]
+    auto timed = [ & ]( TickPhase phase, std::function<void()> fn )
+    {
+        auto start = steady_clock::now();
+        fn();
+        if ( phases )
+        {
+            phases[ phase ] = duration<double>( steady_clock::now() - start ).count();
+        }
+    };
+
+    bool const useJumpgates = config.useJumpgates;
+    timed( TickPhase_Detail, [ & ]()
+    {
+        schedule.advance( delta );
+        lod.update( sectors, { player->sector }, delta, useJumpgates );
+        traffic.update( schedule, sectors, lod, player, delta, useJumpgates );
+        respawnShips( schedule, player, stations, useJumpgates );
+    });
+    timed( TickPhase_Movement, [ & ]()
+    {
+        moveShips( schedule, sectors, player, useJumpgates );
+    });
+    timed( TickPhase_Combat, [ & ]()
+    {
+        acquireTargets( sectors, schedule );
+        fireWeapons( schedule, sectors );
+        resolveCombat( schedule, sectors );
+    });
+}
+
+
+void World::rewire( World const& o )
+{
+    auto sectorIn = [ this ]( Sector* sector ) -> Sector*
+    {
+        return sector ? &sectors[ sector->rowcol.first ][ sector->rowcol.second ] : nullptr;
+    };
+    auto jumpgateIn = [ & ]( Jumpgate* jumpgate ) { return rebase( jumpgate, o.jumpgates, jumpgates ); };
+    auto stationIn  = [ & ]( Station* station )   { return rebase( station, o.stations, stations ); };
+    auto shipIn     = [ & ]( Ship* ship )         { return rebase( ship, o.ships, ships ); };
+    auto objectIn   = [ & ]( HasIDAndSectorAndPosition* object ) -> HasIDAndSectorAndPosition*
+    {
+        if ( ! object ) return nullptr;
+        switch ( object->idType )
+        {
+            case IdType_Jumpgate: return jumpgateIn( static_cast<Jumpgate*>( object ));
+            case IdType_Station:  return stationIn( static_cast<Station*>( object ));
+            case IdType_Ship:     return shipIn( static_cast<Ship*>( object ));
+            default:              return nullptr;
+        }
+    };
+
+    for ( auto& sectorRow : sectors )
+    {
+        for ( auto& sector : sectorRow )
+        {
+            sector.neighbors.north = sectorIn( sector.neighbors.north );
+            sector.neighbors.east  = sectorIn( sector.neighbors.east );
+            sector.neighbors.south = sectorIn( sector.neighbors.south );
+            sector.neighbors.west  = sectorIn( sector.neighbors.west );
+            sector.jumpgates.north = jumpgateIn( sector.jumpgates.north );
+            sector.jumpgates.east  = jumpgateIn( sector.jumpgates.east );
+            sector.jumpgates.south = jumpgateIn( sector.jumpgates.south );
+            sector.jumpgates.west  = jumpgateIn( sector.jumpgates.west );
+
+            station_ptrs_set_t sectorStations;
+            for ( Station* station : sector.stations ) sectorStations.insert( stationIn( station ));
+            sector.stations = std::move( sectorStations );
+
+            // rebuilds the roster, so it shares no nodes with the original's
+            sector.relocateShips( shipIn );
+        }
+    }
+    for ( auto& jumpgate : jumpgates )
+    {
+        jumpgate.sector = sectorIn( jumpgate.sector );
+        jumpgate.target = jumpgateIn( jumpgate.target );
+    }
+    for ( auto& station : stations )
+    {
+        station.sector = sectorIn( station.sector );
+    }
+    for ( auto& ship : ships )
+    {
+        ship.sector  = sectorIn( ship.sector );
+        ship.target  = objectIn( ship.target );
+        ship.journey = sectorIn( ship.journey );
+        if ( destination_ptr_t destination = ship.destination )
+        {
+            auto copy    = std::make_shared<Destination>( *destination );
+            copy->sector = sectorIn( copy->sector );
+            copy->object = objectIn( copy->object );
+            ship.destination = copy;
+        }
+        for ( auto& weapon : ship.weapons() ) weapon->target = objectIn( weapon->target );
+        for ( auto& turret : ship.turrets() ) turret->target = objectIn( turret->target );
+    }
+
+    schedule.relocateShips( shipIn );
+    traffic.relocateShips( shipIn );
+    lod.relocateSectors( sectorIn );
+}
+
+
+} // tinyspace
@@ -0,0 +1,85 @@
+// world.hpp (tiny space v3 - experiment: snapshot serialization) (C++11)
+// LICENSE: WTFPL/PDM/CC0... your choice
+
+
+#ifndef _TINYSPACE_WORLD_HPP_
+#define _TINYSPACE_WORLD_HPP_
+
+
+#include <cstdint>
+#include <memory>
+#include "budget.hpp"
+#include "locality.hpp"
+#include "lod.hpp"
+#include "models.hpp"
+#include "replay.hpp"
+#include "schedule.hpp"
+#include "traffic.hpp"
+#include "types.hpp"
+
+
+namespace tinyspace {
+
+
+// Everything a tick reads and writes -- the universe, its schedulers, and
+// the random stream and id counter its draws and spawns come from.
+//
+// Clones are for what-if runs ("where is this fleet in 60s if it jumps?"):
+// an independent copy that can be stepped on another thread and thrown
+// away. Records live in four flat arrays, so a clone is four bulk copies
+// plus one pass that rewires each pointer by its index -- a pointer into
+// the original's ships is the same index into the clone's, sectors go by
+// rowcol, and targets by idType. Weapons and destinations are copied per
+// ship. Relative address order survives the copy, so the ordered rosters
+// (sector ships) come out as they went in. Each clone carries its own
+// random stream, and its writes set nothing aside for saves (DetachedWrites,
+// opt/saveable.hpp) -- a clone steps single buffered whatever the original.
+// The route table is immutable and keeps no pointers, so clones share it.
+struct World
+{
+    ReplayConfig  config;
+    sectors_t     sectors;
+    jumpgates_t   jumpgates;
+    routes_ptr_t  routes;     // next hops between sectors -- immutable, so clones share it
+    stations_t    stations;
+    ships_t       ships;
+    ShipLocality  locality;
+    ShipHandle    playerHandle;
+    Ship*         player;     // re-resolved from playerHandle after storage reorders
+    Schedule      schedule;
+    LevelOfDetail lod;
+    Traffic       traffic;
+    bool const    isClone;
+
+    // Builds the universe from the calling thread's random stream (seedRand)
+    World( ReplayConfig const& config, size_t shipCount, v2size_t const& bounds, dimensions_t const& sectorSize );
+    ~World();
+
+    World( World const& ) = delete;
+    World& operator =( World const& ) = delete;
+
+    // An independent copy that draws what the original would -- stepped
+    // alike, the two stay identical
+    std::unique_ptr<World> clone() const;
+    // ...that draws from its own stream, seeded as seedRand( seed ) would
+    std::unique_ptr<World> clone( uint64_t seed ) const;
+
+    // One tick, on the calling thread -- detail, movement and combat, timed
+    // into phases[] if given (TickPhase_END entries)
+    void advance( double delta, double* phases=nullptr );
+
+private:
+    uint64_t _stream; // random stream between steps (rand.hpp)
+    id_t     _lastId; // id counter between steps
+
+    World( World const& o, uint64_t stream );
+
+    // Points everything copied from o at this world's records
+    void rewire( World const& o );
+};
+
+
+} // tinyspace
+
+
+#endif // _TINYSPACE_WORLD_HPP_